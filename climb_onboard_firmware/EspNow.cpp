@@ -68,10 +68,12 @@ bool EspNow_init(const uint8_t peer_mac[6]) {
 }
 
 bool EspNow_send(const String& line) {
-  if (!line.length()) return true;
-  return esp_now_send(peer.peer_addr,
-                      reinterpret_cast<const uint8_t*>(line.c_str()),
-                      line.length()) == ESP_OK;
+  return EspNow_send(reinterpret_cast<const uint8_t*>(line.c_str()), line.length());
+}
+
+bool EspNow_send(const uint8_t* data, size_t len) {
+  if (!len) return true;
+  return esp_now_send(peer.peer_addr, data, len) == ESP_OK;
 }
 
 void EspNow_loop() {
@@ -7,6 +7,7 @@
 // === Public API ===
 bool EspNow_init(const uint8_t peer_mac[6]);   // setup WiFi STA, esp_now, register callbacks
 bool EspNow_send(const String& line);          // send a String to peer
+bool EspNow_send(const uint8_t* data, size_t len); // send raw bytes to peer
 void EspNow_loop();                            // poll internal RX queue and dispatch to callback
 
 // Command callback that your main will set (e.g., handleCommandLine)
@@ -0,0 +1,103 @@
+#include "Estimator.h"
+#include <math.h>
+
+static constexpr float GRAVITY = 9.80665f;
+
+void Estimator::update(const Movella& imu1, const Movella& imu2, bool fresh1, bool fresh2) {
+  float q1[4], q2[4], a[3], g[3];
+  imu1.getQuaternion(q1);
+  imu2.getQuaternion(q2);
+
+  // Bias-compensated gyros (bias only learned from new samples)
+  imu1.getGyro(g);
+  if (fresh1) { imu1.getAcceleration(a); learnBias(a, g, bias1_, still1_); }
+  for (int i = 0; i < 3; ++i) gyro1_[i] = g[i] - bias1_[i];
+
+  imu2.getGyro(g);
+  if (fresh2) { imu2.getAcceleration(a); learnBias(a, g, bias2_, still2_); }
+  for (int i = 0; i < 3; ++i) gyro2_[i] = g[i] - bias2_[i];
+
+  // Relative orientation, normalized and on the w >= 0 hemisphere
+  quatConjMul(q1, q2, qrel_);
+  float n = sqrtf(qrel_[0]*qrel_[0] + qrel_[1]*qrel_[1] + qrel_[2]*qrel_[2] + qrel_[3]*qrel_[3]);
+  float s = (n > 1e-6f) ? 1.0f / n : 0.0f;
+  if (qrel_[0] < 0.0f) s = -s;
+  if (n > 1e-6f) { for (int i = 0; i < 4; ++i) qrel_[i] *= s; }
+  else           { qrel_[0] = 1; qrel_[1] = qrel_[2] = qrel_[3] = 0; }
+
+  joint_ = quatAngle(qrel_);
+  tilt1_ = quatTilt(q1);
+  tilt2_ = quatTilt(q2);
+
+  // Relative rate in IMU2 frame: ω2 − R(qrel)ᵀ ω1
+  float w1in2[3];
+  quatRotateInv(qrel_, gyro1_, w1in2);
+  for (int i = 0; i < 3; ++i) wrel_[i] = gyro2_[i] - w1in2[i];
+}
+
+void Estimator::resetBias() {
+  for (int i = 0; i < 3; ++i) { bias1_[i] = 0; bias2_[i] = 0; }
+  still1_ = still2_ = 0;
+}
+
+void Estimator::getGyro(int imu, float out[3]) const {
+  const float* g = (imu == 2) ? gyro2_ : gyro1_;
+  for (int i = 0; i < 3; ++i) out[i] = g[i];
+}
+
+void Estimator::getBias(int imu, float out[3]) const {
+  const float* b = (imu == 2) ? bias2_ : bias1_;
+  for (int i = 0; i < 3; ++i) out[i] = b[i];
+}
+
+// ---------- private ----------
+
+// Stationary detector + EMA on the raw gyro
+void Estimator::learnBias(const float acc[3], const float gyro[3], float bias[3], int& still) {
+  float g2 = gyro[0]*gyro[0] + gyro[1]*gyro[1] + gyro[2]*gyro[2];
+  float an = sqrtf(acc[0]*acc[0] + acc[1]*acc[1] + acc[2]*acc[2]);
+
+  if (g2 < stillGyro * stillGyro && fabsf(an - GRAVITY) < stillAccTol) {
+    if (still < stillCount) { ++still; return; }
+    for (int i = 0; i < 3; ++i) bias[i] += biasAlpha * (gyro[i] - bias[i]);
+  } else {
+    still = 0;
+  }
+}
+
+// ---------- quaternion helpers (w,x,y,z) ----------
+
+// out = conj(a) · b  (a unit → a⁻¹ · b)
+void Estimator::quatConjMul(const float a[4], const float b[4], float out[4]) {
+  const float aw = a[0], ax = -a[1], ay = -a[2], az = -a[3];
+  out[0] = aw*b[0] - ax*b[1] - ay*b[2] - az*b[3];
+  out[1] = aw*b[1] + ax*b[0] + ay*b[3] - az*b[2];
+  out[2] = aw*b[2] - ax*b[3] + ay*b[0] + az*b[1];
+  out[3] = aw*b[3] + ax*b[2] - ay*b[1] + az*b[0];
+}
+
+// out = R(q)ᵀ v = conj(q) · v · q
+void Estimator::quatRotateInv(const float q[4], const float v[3], float out[3]) {
+  // v' = v + 2 u × (u × v − w v), with u = −q.xyz (conjugate)
+  const float w = q[0], ux = -q[1], uy = -q[2], uz = -q[3];
+  float tx = 2.0f * (uy*v[2] - uz*v[1]);
+  float ty = 2.0f * (uz*v[0] - ux*v[2]);
+  float tz = 2.0f * (ux*v[1] - uy*v[0]);
+  out[0] = v[0] + w*tx + (uy*tz - uz*ty);
+  out[1] = v[1] + w*ty + (uz*tx - ux*tz);
+  out[2] = v[2] + w*tz + (ux*ty - uy*tx);
+}
+
+// Rotation angle [0..π]; atan2 form stays accurate near 0
+float Estimator::quatAngle(const float q[4]) {
+  float vn = sqrtf(q[1]*q[1] + q[2]*q[2] + q[3]*q[3]);
+  return 2.0f * atan2f(vn, fabsf(q[0]));
+}
+
+// Angle between the sensor z-axis and global up: R(q)[2][2] = 1 − 2(x² + y²)
+float Estimator::quatTilt(const float q[4]) {
+  float c = 1.0f - 2.0f * (q[1]*q[1] + q[2]*q[2]);
+  if (c > 1.0f) c = 1.0f;
+  if (c < -1.0f) c = -1.0f;
+  return acosf(c);
+}
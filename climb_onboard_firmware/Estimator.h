@@ -0,0 +1,60 @@
+#pragma once
+#include <Arduino.h>
+#include "Movella.h"
+
+// Dual-IMU derived state, computed onboard from the latest Movella samples.
+//
+// Quaternions are Xsens order (q0 = w, q1..q3 = x,y,z), sensor → global (z up).
+// Everything is fixed-size float math on member arrays: no heap, no doubles.
+//
+//   qrel   = q1⁻¹ · q2                 (IMU2 orientation seen from IMU1, w >= 0)
+//   joint  = rotation angle of qrel    [rad, 0..π]
+//   tilt_i = angle of IMU i z-axis from vertical [rad]
+//   gyro_i = gyro_i - bias_i           (bias learned while the IMU is still)
+//   wrel   = gyro2 - R(qrel)ᵀ · gyro1  (relative angular rate, IMU2 frame) [rad/s]
+class Estimator {
+public:
+  Estimator() = default;
+
+  // Feed the latest samples; fresh1/fresh2 say which IMU decoded a new packet
+  // (bias learning only runs on fresh samples).
+  void update(const Movella& imu1, const Movella& imu2, bool fresh1, bool fresh2);
+
+  // Forget learned gyro bias
+  void resetBias();
+
+  // Accessors (copy out)
+  void getRelQuaternion(float out[4]) const { for (int i=0;i<4;++i) out[i]=qrel_[i]; }
+  void getGyro(int imu, float out[3]) const;       // bias-compensated, imu = 1 | 2
+  void getBias(int imu, float out[3]) const;
+  void getRelGyro(float out[3]) const { for (int i=0;i<3;++i) out[i]=wrel_[i]; }
+  float jointAngle() const { return joint_; }
+  float tilt(int imu) const { return imu == 2 ? tilt2_ : tilt1_; }
+
+  // Tuning (defaults suit the MTi at 100 Hz)
+  float stillGyro   = 0.05f;   // |gyro| below this [rad/s] ...
+  float stillAccTol = 0.5f;    // ... and | |acc| - g | below this [m/s²] ...
+  int   stillCount  = 50;      // ... for this many samples → learn bias
+  float biasAlpha   = 0.01f;   // EMA weight per still sample
+
+  // Quaternion helpers (w,x,y,z); public so host code can reuse them
+  static void quatConjMul(const float a[4], const float b[4], float out[4]);  // a⁻¹·b
+  static void quatRotateInv(const float q[4], const float v[3], float out[3]); // R(q)ᵀ·v
+  static float quatAngle(const float q[4]);
+  static float quatTilt(const float q[4]);
+
+private:
+  void learnBias(const float acc[3], const float gyro[3], float bias[3], int& still);
+
+  float qrel_[4]  = {1,0,0,0};
+  float joint_    = 0.f;
+  float tilt1_    = 0.f;
+  float tilt2_    = 0.f;
+  float bias1_[3] = {0,0,0};
+  float bias2_[3] = {0,0,0};
+  float gyro1_[3] = {0,0,0};
+  float gyro2_[3] = {0,0,0};
+  float wrel_[3]  = {0,0,0};
+  int   still1_   = 0;
+  int   still2_   = 0;
+};
@@ -20,6 +20,7 @@ public:
   void update();
 
   float lastCommand() const { return cmd_; }
+  uint32_t frequency() const { return pwmHz_; }
 
 private:
   uint8_t  rpwm_, lpwm_;
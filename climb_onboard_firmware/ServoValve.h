@@ -14,6 +14,9 @@ public:
   // Set target angle in degrees (0–90). Clamped if out of range.
   void setAngle(float deg);
 
+  // Last commanded angle in degrees (after clamping)
+  float angle() const { return angle_deg_; }
+
   // Send one 20 ms pulse frame (call every loop or with a timer)
   void sendFrame();
 
@@ -0,0 +1,60 @@
+#include "SetpointRx.h"
+#include <stdio.h>
+#include <ctype.h>
+
+bool SetpointMsg_parse(const char* args, SetpointMsg& out) {
+  unsigned long session = 0, seq = 0, hz = 0;
+  float v1 = 0, v2 = 0, duty = 0;
+  int end = -1;
+  if (sscanf(args, " %lu %lu %f %f %f %lu%n",
+             &session, &seq, &v1, &v2, &duty, &hz, &end) != 6 || end < 0) {
+    return false;
+  }
+  for (const char* p = args + end; *p; ++p) {
+    if (!isspace((unsigned char)*p)) return false;
+  }
+  out.session = (uint32_t)session;
+  out.seq     = (uint32_t)seq;
+  out.v1      = v1;
+  out.v2      = v2;
+  out.duty    = duty;
+  out.hz      = (uint32_t)hz;
+  return true;
+}
+
+size_t SetpointAck_format(const SetpointMsg& msg, char* buf, size_t cap) {
+  if (!cap) return 0;
+  int n = snprintf(buf, cap, "ack %lu %lu", (unsigned long)msg.session, (unsigned long)msg.seq);
+  return (n < 0) ? 0 : ((size_t)n < cap ? (size_t)n : cap - 1);
+}
+
+SetpointFilter::Verdict SetpointFilter::accept(const SetpointMsg& msg) {
+  Verdict v;
+  if (!have_ || msg.session != session_) {
+    v = NEW_SESSION;
+  } else {
+    int32_t d = (int32_t)(msg.seq - seq_);   // wrap-safe
+    if (d == 0) return DUPLICATE;
+    if (d < 0)  return STALE;
+    v = APPLY;
+  }
+  have_    = true;
+  session_ = msg.session;
+  seq_     = msg.seq;
+  return v;
+}
+
+static float clampf(float x, float lo, float hi) {
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+SetpointState SetpointMsg_apply(const SetpointMsg& msg, SetpointFilter::Verdict v,
+                                const SetpointState& cur) {
+  if (v != SetpointFilter::APPLY && v != SetpointFilter::NEW_SESSION) return cur;
+  SetpointState s;
+  s.v1   = clampf(msg.v1, 0.0f, 90.0f);
+  s.v2   = clampf(msg.v2, 0.0f, 90.0f);
+  s.duty = clampf(msg.duty, -1.0f, 1.0f);
+  s.hz   = msg.hz < 100 ? 100 : (msg.hz > 2000 ? 2000 : msg.hz);
+  return s;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Receive side of the dongle's compound setpoint
+//   "sp <session> <seq> <v1> <v2> <duty> <hz>"
+// Plain C strings only, so it also builds on the host (see test/).
+struct SetpointMsg {
+  uint32_t session;
+  uint32_t seq;
+  float    v1, v2, duty;
+  uint32_t hz;
+};
+
+// Parse the arguments after "sp "; exactly six numbers, nothing else.
+bool SetpointMsg_parse(const char* args, SetpointMsg& out);
+
+// "ack <session> <seq>" back to the dongle, so it stops re-sending msg
+size_t SetpointAck_format(const SetpointMsg& msg, char* buf, size_t cap);
+
+// Per-session sequence filter. A new session (dongle reboot) always applies
+// and restarts the filter; within a session only newer seqs apply.
+class SetpointFilter {
+public:
+  enum Verdict : uint8_t { APPLY, NEW_SESSION, DUPLICATE, STALE };
+
+  // Classify msg; APPLY / NEW_SESSION also record it as the latest
+  Verdict accept(const SetpointMsg& msg);
+
+  bool     have()    const { return have_; }
+  uint32_t session() const { return session_; }
+  uint32_t seq()     const { return seq_; }
+
+private:
+  bool     have_    = false;
+  uint32_t session_ = 0;
+  uint32_t seq_     = 0;
+};
+
+// Whole actuator state as the onboard applies it
+struct SetpointState {
+  float    v1, v2;   // valve angles, deg 0..90 (ServoValve)
+  float    duty;     // motor -1..1 (Motor)
+  uint32_t hz;       // motor PWM, 100..2000 (same limits as 'mf')
+};
+
+// State after msg with its filter verdict: APPLY / NEW_SESSION give all four
+// fields of msg, clamped; DUPLICATE / STALE give cur unchanged. Never a mix.
+SetpointState SetpointMsg_apply(const SetpointMsg& msg, SetpointFilter::Verdict v,
+                                const SetpointState& cur);
@@ -0,0 +1,111 @@
+#include "Telemetry.h"
+#include <ArduinoJson.h>     // v7+
+
+Telemetry::Telemetry(Movella& imu1, Movella& imu2, Motor& motor,
+                     ServoValve& valve1, ServoValve& valve2, const Estimator& est)
+: imu1_(imu1), imu2_(imu2), motor_(motor), valve1_(valve1), valve2_(valve2), est_(est) {}
+
+void Telemetry::reset() {
+  configured_ = false;
+  sendHeader_ = false;
+  configJson_ = "";
+}
+
+// ---- CONFIG → plan ----
+bool Telemetry::applyConfigJSON(const String& json, String& reply) {
+  StaticJsonDocument<2048> doc;
+  DeserializationError err = deserializeJson(doc, json);
+  if (err) { reply = String("ERR CONFIG: ") + err.c_str(); return false; }
+
+  JsonArray arr = doc["fields"];
+  if (arr.isNull()) { reply = "ERR CONFIG: fields missing"; return false; }
+
+  uint32_t rateHz = doc["rate_hz"] | 100;
+
+  // Build into the inactive buffer; the TX task keeps using the active one
+  Plan& p = plans_[active_ ^ 1];
+  p.begin(rateHz, doc["include_timestamp"] | true);
+
+  char msg[64];
+  for (JsonVariant f : arr) {
+    bool ok;
+    if (f.is<const char*>()) {
+      // Shorthand "source.path", e.g. "imu1.quat" (keeps CONFIG under one ESP-NOW packet)
+      String s = f.as<const char*>();
+      int dot = s.indexOf('.');
+      String src  = dot < 0 ? s : s.substring(0, dot);
+      String path = dot < 0 ? String("") : s.substring(dot + 1);
+      ok = p.add(nullptr, src.c_str(), path.c_str(), rateHz, Plan::DEFAULT_PREC, msg, sizeof(msg));
+    } else {
+      const char* name = f["name"];   // nullptr → "source.path" header
+      const char* src  = f["source"]  | "";
+      const char* pth  = f["path"]    | "";
+      uint32_t    hz   = f["rate_hz"] | rateHz;
+      uint8_t     prec = f["prec"]    | uint8_t(Plan::DEFAULT_PREC);
+      ok = p.add(name, src, pth, hz, prec, msg, sizeof(msg));
+    }
+    if (!ok) { reply = msg; return false; }
+  }
+  if (!p.finish(msg, sizeof(msg))) { reply = msg; return false; }
+
+  active_     = active_ ^ 1;
+  tick_       = 0;
+  configured_ = true;
+  sendHeader_ = true;
+  configJson_ = json;
+  reply = "OK CONFIG";
+  return true;
+}
+
+// ---- Per-tick path ----
+void Telemetry::sample(uint8_t mask, uint32_t txCount) {
+  if (mask & Plan::SRC_IMU1) {
+    imu1_.getQuaternion(&f_[Plan::IMU1_Q0]);
+    imu1_.getAcceleration(&f_[Plan::IMU1_Q0 + 4]);
+    imu1_.getGyro(&f_[Plan::IMU1_Q0 + 7]);
+    u_[Plan::IMU1_ID] = (uint32_t)imu1_.id();
+    f_[Plan::IMU1_Q0 + 11] = imu1_.frequencyHz();
+  }
+  if (mask & Plan::SRC_IMU2) {
+    imu2_.getQuaternion(&f_[Plan::IMU2_Q0]);
+    imu2_.getAcceleration(&f_[Plan::IMU2_Q0 + 4]);
+    imu2_.getGyro(&f_[Plan::IMU2_Q0 + 7]);
+    u_[Plan::IMU2_ID] = (uint32_t)imu2_.id();
+    f_[Plan::IMU2_Q0 + 11] = imu2_.frequencyHz();
+  }
+  if (mask & Plan::SRC_MOTOR) {
+    f_[Plan::MOTOR_CMD] = motor_.lastCommand();
+    u_[Plan::MOTOR_HZ]  = motor_.frequency();
+  }
+  if (mask & Plan::SRC_VALVES) {
+    f_[Plan::VALVE1_DEG] = valve1_.angle();
+    f_[Plan::VALVE2_DEG] = valve2_.angle();
+  }
+  if (mask & Plan::SRC_EST) {
+    est_.getRelQuaternion(&f_[Plan::EST_QREL]);
+    f_[Plan::EST_QREL + 4] = est_.jointAngle();
+    f_[Plan::EST_QREL + 5] = est_.tilt(1);
+    f_[Plan::EST_QREL + 6] = est_.tilt(2);
+    est_.getGyro(1, &f_[Plan::EST_QREL + 7]);
+    est_.getGyro(2, &f_[Plan::EST_QREL + 10]);
+    est_.getRelGyro(&f_[Plan::EST_QREL + 13]);
+  }
+  u_[Plan::TX_COUNT] = txCount;
+  u_[Plan::TICK]     = tick_;
+}
+
+size_t Telemetry::build(uint32_t ms, uint32_t txCount, char* out, size_t cap) {
+  const Plan& p = plans_[active_];
+  if (cap < 2) return 0;
+
+  if (sendHeader_) {
+    sendHeader_ = false;
+    strlcpy(out, p.header(), cap);
+    return strlen(out);
+  }
+
+  sample(p.srcMask(), txCount);
+  size_t len = p.format(tick_, ms, f_, u_, out, cap);
+  ++tick_;
+  return len;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+#include "Movella.h"
+#include "Motor.h"
+#include "ServoValve.h"
+#include "Estimator.h"
+#include "TelemetryPlan.h"
+
+// Runtime-configurable telemetry line, same idea as the arganello CONFIG.
+//
+// A CONFIG JSON selects which channels go into each line and at what rate.
+// It is compiled once into a flat emit plan (TelemetryPlan), so the per-tick
+// path only copies the needed sources and formats the selected values — no
+// string compares or lookups. This class is the JSON/String glue around it.
+//
+// Example:
+//   CONFIG {"rate_hz":100,"fields":["imu1.quat","imu2.quat"]}
+//   CONFIG {"rate_hz":50,"fields":[{"name":"duty","source":"motor","path":"cmd","rate_hz":10}]}
+//   CONFIG {"fields":["est.qrel","est.joint","est.wrel"]}   // derived state instead of raw IMUs
+class Telemetry {
+public:
+  static constexpr size_t MAX_LINE = TelemetryPlan::MAX_LINE;
+
+  Telemetry(Movella& imu1, Movella& imu2, Motor& motor,
+            ServoValve& valve1, ServoValve& valve2, const Estimator& est);
+
+  // Parse a CONFIG JSON and swap in the new plan. On failure the previous plan
+  // stays active and `reply` holds the error.
+  bool applyConfigJSON(const String& json, String& reply);
+
+  // Drop the CONFIG and go back to the legacy full dual-IMU line
+  void reset();
+
+  // Send the CSV header again before the next line (e.g. on GET_CONFIG)
+  void requestHeader() { if (configured_) sendHeader_ = true; }
+
+  bool configured() const { return configured_; }
+  const String& configJson() const { return configJson_; }
+
+  // Tick period requested by the active plan
+  uint32_t periodMs() const { return plans_[active_].periodMs(); }
+
+  // Build one line (with trailing '\n') into out; returns its length.
+  // The first line after a CONFIG is the CSV header.
+  size_t build(uint32_t ms, uint32_t txCount, char* out, size_t cap);
+
+private:
+  using Plan = TelemetryPlan;
+
+  void sample(uint8_t mask, uint32_t txCount);
+
+  Movella&    imu1_;
+  Movella&    imu2_;
+  Motor&      motor_;
+  ServoValve& valve1_;
+  ServoValve& valve2_;
+  const Estimator& est_;
+
+  // Double-buffered: the TX task reads plans_[active_] while CONFIG fills the other
+  Plan             plans_[2];
+  volatile uint8_t active_      = 0;
+  volatile bool    configured_  = false;
+  volatile bool    sendHeader_  = false;
+  String           configJson_;
+
+  uint32_t tick_ = 0;
+  float    f_[Plan::CH_COUNT] = {0};
+  uint32_t u_[Plan::CH_COUNT] = {0};
+};
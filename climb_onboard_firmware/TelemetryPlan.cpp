@@ -0,0 +1,219 @@
+#include "TelemetryPlan.h"
+#include <stdio.h>
+#include <string.h>
+
+// ---- Channel name table (source + path → first channel, count) ----
+struct ChannelDef {
+  const char* path;
+  uint8_t     offset;   // from the source's first channel
+  uint8_t     count;
+};
+
+// Per-IMU layout, mirrors Movella::printCSV (q0..q3, ax..az, gx..gz, id) + hz
+static const ChannelDef IMU_DEFS[] = {
+  {"q0", 0, 1}, {"q1", 1, 1}, {"q2", 2, 1}, {"q3", 3, 1},
+  {"ax", 4, 1}, {"ay", 5, 1}, {"az", 6, 1},
+  {"gx", 7, 1}, {"gy", 8, 1}, {"gz", 9, 1},
+  {"id", 10, 1}, {"hz", 11, 1},
+  // groups
+  {"quat", 0, 4}, {"acc", 4, 3}, {"gyro", 7, 3}, {"all", 0, 11},
+};
+static const char* const IMU_NAMES[12] = {
+  "q0","q1","q2","q3","ax","ay","az","gx","gy","gz","id","hz"
+};
+
+// Estimator layout (see Estimator.h)
+static const ChannelDef EST_DEFS[] = {
+  {"qw", 0, 1}, {"qx", 1, 1}, {"qy", 2, 1}, {"qz", 3, 1},
+  {"joint", 4, 1}, {"tilt1", 5, 1}, {"tilt2", 6, 1},
+  {"g1x", 7, 1}, {"g1y", 8, 1}, {"g1z", 9, 1},
+  {"g2x", 10, 1}, {"g2y", 11, 1}, {"g2z", 12, 1},
+  {"wx", 13, 1}, {"wy", 14, 1}, {"wz", 15, 1},
+  // groups
+  {"qrel", 0, 4}, {"tilt", 5, 2}, {"gyro1", 7, 3}, {"gyro2", 10, 3}, {"wrel", 13, 3},
+  {"all", 0, 16},
+};
+static const char* const EST_NAMES[16] = {
+  "qw","qx","qy","qz","joint","tilt1","tilt2",
+  "g1x","g1y","g1z","g2x","g2y","g2z","wx","wy","wz"
+};
+
+static const uint8_t TS_DIGITS = 10;  // millis() as %lu
+
+// Saturation limits per integer-digit count, so a cell never exceeds its width
+static const float    FLOAT_LIMIT[] = { 0.f, 9.f, 99.f, 999.f, 9999.f };
+static const uint32_t INT_LIMIT[]   = { 0, 9, 99, 999, 9999 };
+
+// Bounded append; false if s (and its NUL) does not fit
+static bool append(char* dst, size_t cap, const char* s) {
+  size_t len = strlen(dst), n = strlen(s);
+  if (len + n + 1 > cap) return false;
+  memcpy(dst + len, s, n + 1);
+  return true;
+}
+
+void TelemetryPlan::begin(uint32_t rateHz, bool timestamp) {
+  if (rateHz < 1) rateHz = 1;
+  if (rateHz > MAX_RATE_HZ) rateHz = MAX_RATE_HZ;
+  n_         = 0;
+  srcMask_   = 0;
+  timestamp_ = timestamp;
+  rateHz_    = rateHz;
+  periodMs_  = 1000UL / rateHz;
+  width_     = timestamp ? TS_DIGITS + 1 : 1;   // + '\n'
+  header_[0] = '\0';
+  if (timestamp) append(header_, sizeof(header_), "ms");
+}
+
+bool TelemetryPlan::add(const char* name, const char* src, const char* path,
+                        uint32_t fieldHz, uint8_t prec, char* err, size_t errCap) {
+  uint8_t first = 0, count = 0, mask = 0;
+  const char* const* subNames = nullptr;
+
+  if (strcmp(src, "imu1") == 0 || strcmp(src, "imu2") == 0) {
+    bool one = (src[3] == '1');
+    const char* key = path[0] ? path : "all";
+    for (const ChannelDef& d : IMU_DEFS) {
+      if (strcmp(d.path, key) == 0) {
+        first = (one ? IMU1_Q0 : IMU2_Q0) + d.offset;
+        count = d.count;
+        break;
+      }
+    }
+    mask = one ? SRC_IMU1 : SRC_IMU2;
+    subNames = IMU_NAMES + (count ? first - (one ? IMU1_Q0 : IMU2_Q0) : 0);
+  } else if (strcmp(src, "est") == 0) {
+    const char* key = path[0] ? path : "all";
+    for (const ChannelDef& d : EST_DEFS) {
+      if (strcmp(d.path, key) == 0) {
+        first = EST_QREL + d.offset;
+        count = d.count;
+        break;
+      }
+    }
+    mask = SRC_EST;
+    subNames = EST_NAMES + (count ? first - EST_QREL : 0);
+  } else if (strcmp(src, "motor") == 0) {
+    if      (strcmp(path, "cmd") == 0) { first = MOTOR_CMD; count = 1; }
+    else if (strcmp(path, "hz")  == 0) { first = MOTOR_HZ;  count = 1; }
+    mask = SRC_MOTOR;
+  } else if (strcmp(src, "valve1") == 0 || strcmp(src, "valve2") == 0) {
+    if (path[0] == '\0') path = "deg";
+    if (strcmp(path, "deg") == 0) {
+      first = (src[5] == '1') ? VALVE1_DEG : VALVE2_DEG;
+      count = 1;
+    }
+    mask = SRC_VALVES;
+  } else if (strcmp(src, "counter") == 0) {
+    if      (strcmp(path, "tx")   == 0) { first = TX_COUNT; count = 1; }
+    else if (strcmp(path, "tick") == 0) { first = TICK;     count = 1; }
+  }
+
+  if (count == 0) {
+    snprintf(err, errCap, "ERR CONFIG: unknown field %s.%s", src, path);
+    return false;
+  }
+  if (n_ + count > MAX_SLOTS) {
+    snprintf(err, errCap, "ERR CONFIG: too many fields");
+    return false;
+  }
+  if (prec > MAX_PREC) prec = MAX_PREC;
+  if (fieldHz < 1) fieldHz = 1;
+  uint32_t every = (fieldHz >= rateHz_) ? 1 : (rateHz_ / fieldHz);
+
+  for (uint8_t i = 0; i < count; ++i) {
+    Slot& s = slots_[n_++];
+    s.ch     = first + i;
+    s.digits = channelDigits(s.ch, s.isInt);
+    s.prec   = s.isInt ? 0 : prec;
+    s.every  = (uint16_t)every;
+
+    // Worst case: sign + digits + '.' + decimals ("-nan" for floats)
+    uint8_t w = s.isInt ? s.digits : (uint8_t)(1 + s.digits + (s.prec ? 1 + s.prec : 0));
+    if (!s.isInt && w < 4) w = 4;
+    s.width = w;
+    width_ += w + ((n_ > 1 || timestamp_) ? 1 : 0);   // + ','
+
+    // Header cell: explicit name (+index for groups) or "source.path"
+    char cell[24];
+    const char* sub = subNames ? subNames[i] : path;
+    if (name && count == 1)  snprintf(cell, sizeof(cell), "%s", name);
+    else if (name)           snprintf(cell, sizeof(cell), "%s%u", name, (unsigned)i);
+    else                     snprintf(cell, sizeof(cell), "%s.%s", src, sub);
+    if ((header_[0] && !append(header_, sizeof(header_), ",")) ||
+        !append(header_, sizeof(header_), cell)) {
+      snprintf(err, errCap, "ERR CONFIG: header too long");
+      return false;
+    }
+  }
+  srcMask_ |= mask;
+  return true;
+}
+
+bool TelemetryPlan::finish(char* err, size_t errCap) {
+  if (width_ > MAX_LINE) {
+    snprintf(err, errCap, "ERR CONFIG: line too long (%u > %u bytes)",
+             (unsigned)width_, (unsigned)MAX_LINE);
+    return false;
+  }
+  if (!append(header_, sizeof(header_), "\n")) {
+    snprintf(err, errCap, "ERR CONFIG: header too long");
+    return false;
+  }
+  return true;
+}
+
+// Integer digits a channel can need; floats are saturated to this at emit time
+uint8_t TelemetryPlan::channelDigits(uint8_t ch, bool& isInt) {
+  isInt = (ch == IMU1_ID) || (ch == IMU2_ID) || (ch == MOTOR_HZ) ||
+          (ch == TX_COUNT) || (ch == TICK);
+  if (ch == TX_COUNT || ch == TICK) return 10;
+  if (ch == MOTOR_HZ) return 4;
+  if (ch <= IMU2_ID + 1) {
+    uint8_t k = (ch - IMU1_Q0) % 12;
+    if (k < 4)   return 1;    // quaternion
+    if (k < 7)   return 3;    // acc, m/s² (MTi range ±160)
+    if (k < 10)  return 2;    // gyro, rad/s
+    if (k == 10) return 3;    // id
+    return 4;                 // hz
+  }
+  if (ch == MOTOR_CMD)  return 1;
+  if (ch == VALVE1_DEG || ch == VALVE2_DEG) return 2;
+  uint8_t k = ch - EST_QREL;
+  return (k < 7) ? 1 : 2;     // qrel/joint/tilt, then rad/s
+}
+
+// ---- Per-tick path ----
+size_t TelemetryPlan::format(uint32_t tick, uint32_t ms, const float* f, const uint32_t* u,
+                             char* out, size_t cap) const {
+  if (cap < 2) return 0;
+
+  size_t len = 0;
+  bool first = true;
+  if (timestamp_) {
+    len += snprintf(out, cap, "%lu", (unsigned long)ms);
+    if (len > cap - 1) len = cap - 1;
+    first = false;
+  }
+  for (uint8_t i = 0; i < n_ && len < cap - 1; ++i) {
+    const Slot& s = slots_[i];
+    if (!first) out[len++] = ',';
+    first = false;
+    if (tick % s.every != 0 || len >= cap - 1) continue;   // empty cell keeps columns aligned
+    if (s.isInt) {
+      uint32_t v = u[s.ch];
+      if (s.digits < 5 && v > INT_LIMIT[s.digits]) v = INT_LIMIT[s.digits];
+      len += snprintf(out + len, cap - len, "%lu", (unsigned long)v);
+    } else {
+      float v = f[s.ch], lim = FLOAT_LIMIT[s.digits];
+      if (v > lim) v = lim;
+      else if (v < -lim) v = -lim;
+      len += snprintf(out + len, cap - len, "%.*f", s.prec, v);
+    }
+    if (len > cap - 1) len = cap - 1;   // only if cap < width()
+  }
+  if (len > cap - 2) len = cap - 2;
+  out[len++] = '\n';
+  out[len]   = '\0';
+  return len;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Compiled telemetry emit plan and line formatter (the CONFIG side is in
+// Telemetry.h). Each selected channel becomes one flat slot with a fixed
+// worst-case width, so a plan that could overflow one ESP-NOW packet is
+// rejected up front and formatting is a straight walk over the slots.
+// Plain C strings only, so it also builds on the host (see test/).
+class TelemetryPlan {
+public:
+  static constexpr size_t  MAX_SLOTS    = 48;
+  static constexpr size_t  MAX_LINE     = 250;   // ESP_NOW_MAX_DATA_LEN
+  static constexpr uint8_t DEFAULT_PREC = 6;
+  static constexpr uint8_t MAX_PREC     = 6;
+  static constexpr uint32_t MAX_RATE_HZ = 200;
+
+  // Flat channel space; IMU blocks share the layout of Movella::printCSV
+  enum Channel : uint8_t {
+    IMU1_Q0 = 0,                // q0..q3, ax..az, gx..gz, id, hz
+    IMU1_ID = IMU1_Q0 + 10,
+    IMU2_Q0 = IMU1_Q0 + 12,
+    IMU2_ID = IMU2_Q0 + 10,
+    MOTOR_CMD = IMU2_Q0 + 12,
+    MOTOR_HZ,
+    VALVE1_DEG,
+    VALVE2_DEG,
+    TX_COUNT,
+    TICK,
+    EST_QREL,                   // w,x,y,z, joint, tilt1, tilt2, gyro1 xyz, gyro2 xyz, wrel xyz
+    EST_END = EST_QREL + 16,
+    CH_COUNT = EST_END
+  };
+
+  // Source groups, so a tick only samples what the plan uses
+  enum SrcMask : uint8_t {
+    SRC_IMU1   = 1 << 0,
+    SRC_IMU2   = 1 << 1,
+    SRC_MOTOR  = 1 << 2,
+    SRC_VALVES = 1 << 3,
+    SRC_EST    = 1 << 4,
+  };
+
+  // Start an empty plan; rateHz is clamped to 1..MAX_RATE_HZ
+  void begin(uint32_t rateHz, bool timestamp);
+
+  // Append "source.path" (groups expand to several slots). name = nullptr
+  // gives "source.path" header cells. On failure err holds "ERR CONFIG: ...".
+  bool add(const char* name, const char* src, const char* path,
+           uint32_t fieldHz, uint8_t prec, char* err, size_t errCap);
+
+  // Final checks: worst-case line fits MAX_LINE, header has room for '\n'
+  bool finish(char* err, size_t errCap);
+
+  // Format one line (with '\n') for tick from channel values f[]/u[]
+  // (indexed by Channel); returns its length, never more than width().
+  size_t format(uint32_t tick, uint32_t ms, const float* f, const uint32_t* u,
+                char* out, size_t cap) const;
+
+  uint8_t     size()     const { return n_; }
+  uint8_t     srcMask()  const { return srcMask_; }
+  uint32_t    periodMs() const { return periodMs_; }
+  uint16_t    width()    const { return width_; }     // worst-case line length
+  uint8_t     slotWidth(uint8_t i) const { return slots_[i].width; }
+  const char* header()   const { return header_; }    // CSV header incl. '\n'
+
+private:
+  struct Slot {
+    uint8_t  ch;
+    bool     isInt;   // from u[] instead of f[]
+    uint8_t  prec;    // decimals (floats)
+    uint8_t  digits;  // integer digits; values are saturated to fit
+    uint8_t  width;   // worst-case cell length
+    uint16_t every;   // emit every N ticks, empty cell otherwise
+  };
+
+  static uint8_t channelDigits(uint8_t ch, bool& isInt);
+
+  Slot     slots_[MAX_SLOTS];
+  uint8_t  n_         = 0;
+  uint8_t  srcMask_   = 0;
+  bool     timestamp_ = true;
+  uint32_t rateHz_    = 100;
+  uint32_t periodMs_  = 10;
+  uint16_t width_     = 0;
+  char     header_[MAX_LINE + 1] = {0};
+};
@@ -8,6 +8,9 @@ What this does
 - Drives ONE DC motor via a BTS7960 (RPWM=GPIO 37, LPWM=GPIO 38) using your *software-PWM* Motor class.
 - Serial + ESP-NOW command console to set angles and motor duty.
 - 100 Hz ESP-NOW telemetry sender: epoch_ms,<imu1_csv_wo_nl>,<imu2_csv_wo_nl>
+  (or a CONFIG-selected subset of channels, see Telemetry.h)
+- Onboard dual-IMU estimator (relative quaternion, joint angle, tilt,
+  bias-compensated gyro), selectable in telemetry as "est.*"
 
 Requirements
 ------------
@@ -20,6 +23,8 @@ Requirements
   * Motor.h / Motor.cpp            (begin(), setFrequency(hz), set(val), stop(), update())
   * Movella.h / Movella.cpp        (imu.begin(...), .update(), .printCSV(Print&))
   * EspNow.h / EspNow.cpp          (from our previous step)
+  * Telemetry.h / Telemetry.cpp    (CONFIG JSON → flat emit plan; needs ArduinoJson v7)
+  * Estimator.h / Estimator.cpp    (relative orientation + derived state from both IMUs)
 
 Wiring (default pins)
 ---------------------
@@ -36,6 +41,16 @@ Serial Commands
 - m<val>       → motor command in [-1..1], e.g. m-1, m0, m0.25, m1
 - mf <hz>      → set motor PWM to arbitrary frequency (e.g., "mf 200")
 - mstop        → stop motor (0 duty)
+- sp <session> <seq> <v1> <v2> <duty> <hz>
+               → atomic setpoint: both valves, motor duty and PWM frequency in
+                 one packet, sent by the dongle; duplicate/stale <seq> within a
+                 <session> are ignored; acked back to the dongle over
+                 ESP-NOW ("ack <session> <seq>"), which re-sends until then
+- CONFIG <json> → select telemetry fields/rate, e.g. CONFIG {"fields":["imu1.quat","imu2.quat"]}
+- GET_CONFIG   → print active telemetry CONFIG and re-send the CSV header
+  (CONFIG replies also go back over ESP-NOW if they fit one packet)
+- RESET_CONFIG → back to the full dual-IMU line
+- ebias        → reset the estimator's learned gyro bias
 - status       → print current angles, motor command, espnow tx count
 - help         → reprint help
 */
@@ -46,6 +61,9 @@ Serial Commands
 #include "Motor.h"
 #include "Movella.h"
 #include "EspNow.h"
+#include "Estimator.h"
+#include "Telemetry.h"
+#include "SetpointRx.h"
 #include <esp_mac.h>  // at top, with other includes
 
 // ── Peer (of dongle) MAC address — CHANGE THIS ───────────────────────────────────
@@ -70,6 +88,15 @@ HardwareSerial Xsens2(1);  // UART1: RX=5,  TX=4
 Movella imu1(Xsens1, 1);
 Movella imu2(Xsens2, 2);
 
+// Derived dual-IMU state, updated by the TX task
+Estimator estimator;
+
+// Telemetry schema (legacy dual-IMU line until a CONFIG arrives)
+Telemetry telemetry(imu1, imu2, motor, ServoValve1, ServoValve2, estimator);
+
+// Last applied compound setpoint (see handleSetpoint)
+SetpointFilter sp_filter;
+
 // ── Simple line reader for Serial ─────────────────────────────────────────────
 String line;
 bool readLine(String& out) {
@@ -90,6 +117,11 @@ void printHelp() {
     "  m<val>     - motor in [-1..1], e.g. m-1, m0, m0.25, m1\n"
     "  mf <hz>    - set motor PWM to <hz>, e.g. 'mf 200'\n"
     "  mstop      - stop motor\n"
+    "  sp <session> <seq> <v1> <v2> <duty> <hz> - set valves + motor at once\n"
+    "  CONFIG <json> - select telemetry fields/rate\n"
+    "  GET_CONFIG - print telemetry CONFIG\n"
+    "  RESET_CONFIG - full dual-IMU telemetry\n"
+    "  ebias      - reset estimator gyro bias\n"
     "  status     - print current state\n"
     "  help       - show this help\n"
   ));
@@ -122,9 +154,24 @@ static inline void rstrip_nl(String& s) {
   while (s.endsWith("\n") || s.endsWith("\r")) s.remove(s.length() - 1);
 }
 
+// Reply to USB Serial *and* the dongle, so a CONFIG sent over ESP-NOW gets
+// its OK/ERR back. The dongle prints each packet as its own line, so a reply
+// that does not fit one packet is replaced by a short notice over ESP-NOW.
+static void replyBoth(const String& msg) {
+  Serial.println(msg);
+  String out = msg + "\n";
+  if (out.length() > Telemetry::MAX_LINE) {
+    out = String("ERR reply too long for ESP-NOW (") + msg.length() + " bytes), read it over USB\n";
+  }
+  EspNow_send(out);
+}
+
 // Shared command parser (Serial + ESP-NOW)
 void handleCommandLine(const String& cmd);
 
+// Compound setpoint ("sp ..."): applied in one step, filtered by sequence number
+bool handleSetpoint(const String& args);
+
 // Build one combined CSV line:
 // epoch_ms,<imu1_csv_wo_nl>,<imu2_csv_wo_nl>\n
 String buildDualImuCsv();
@@ -221,7 +268,24 @@ void handleCommandLine(const String& in) {
   String cmd = in; cmd.trim();
   String low = cmd; low.toLowerCase();
 
-  if (low.startsWith("s1")) {
+  // Telemetry CONFIG (case-sensitive, like the arganello firmware)
+  if (cmd.startsWith("CONFIG ")) {
+    String reply;
+    telemetry.applyConfigJSON(cmd.substring(7), reply);
+    replyBoth(reply);
+
+  } else if (cmd == "GET_CONFIG") {
+    replyBoth(telemetry.configured() ? telemetry.configJson() : String("(default)"));
+    telemetry.requestHeader();   // header went out once over a lossy link
+
+  } else if (cmd == "RESET_CONFIG") {
+    telemetry.reset();
+    replyBoth("OK RESET_CONFIG");
+
+  } else if (low.startsWith("sp ")) {
+    handleSetpoint(cmd.substring(3));
+
+  } else if (low.startsWith("s1")) {
     float v = cmd.substring(2).toFloat();
     ServoValve1.setAngle(v);
     Serial.printf("Valve1 -> %.1f deg\n", v);
@@ -260,6 +324,15 @@ void handleCommandLine(const String& in) {
     Serial.println("(Angles are whatever you last set; ServoValve stores them internally.)");
     Serial.printf("Motor duty cmd: %.3f\n", motor.lastCommand());
     Serial.printf("ESP-NOW tx_count: %lu\n", (unsigned long)EspNow_txCount());
+    Serial.printf("Setpoint session: %lu  seq: %lu\n",
+                  (unsigned long)sp_filter.session(), (unsigned long)sp_filter.seq());
+    Serial.printf("Joint angle: %.2f deg  tilt1: %.2f deg  tilt2: %.2f deg\n",
+                  degrees(estimator.jointAngle()),
+                  degrees(estimator.tilt(1)), degrees(estimator.tilt(2)));
+
+  } else if (low == "ebias") {
+    estimator.resetBias();
+    Serial.println("Estimator gyro bias reset.");
 
   } else if (low == "help" || low == "?") {
     printHelp();
@@ -269,12 +342,60 @@ void handleCommandLine(const String& in) {
   }
 }
 
+// ── Compound setpoint ─────────────────────────────────────────────────────────
+// "sp <session> <seq> <v1> <v2> <duty> <hz>" carries the whole actuator
+// state, so one packet replaces s1 + s2 + m (+ mf) and all four land in the
+// same loop(). Each accepted or duplicate setpoint is acked over ESP-NOW
+// ("ack <session> <seq>"); the dongle re-sends until then. Within a session
+// equal seqs are dropped silently and older ones with a log line. A new
+// session (dongle reboot) resets the filter.
+bool handleSetpoint(const String& args) {
+  SetpointMsg sp;
+  if (!SetpointMsg_parse(args.c_str(), sp)) {
+    Serial.println("Usage: sp <session> <seq> <v1> <v2> <duty> <hz>");
+    return false;
+  }
+
+  uint32_t lastSeq = sp_filter.seq();
+  SetpointFilter::Verdict v = sp_filter.accept(sp);
+  if (v != SetpointFilter::STALE) {
+    // Ack also duplicates: the dongle re-sends until an ack gets through
+    char ack[32];
+    size_t n = SetpointAck_format(sp, ack, sizeof(ack));
+    EspNow_send(reinterpret_cast<const uint8_t*>(ack), n);
+  }
+  switch (v) {
+    case SetpointFilter::DUPLICATE:
+      return false;
+    case SetpointFilter::STALE:
+      Serial.printf("Setpoint #%lu dropped (stale, last #%lu)\n",
+                    (unsigned long)sp.seq, (unsigned long)lastSeq);
+      return false;
+    case SetpointFilter::NEW_SESSION:
+      Serial.printf("Setpoint session %lu\n", (unsigned long)sp.session);
+      break;
+    case SetpointFilter::APPLY:
+      break;
+  }
+
+  SetpointState cur = { ServoValve1.angle(), ServoValve2.angle(),
+                        motor.lastCommand(), motor.frequency() };
+  SetpointState next = SetpointMsg_apply(sp, v, cur);
+  ServoValve1.setAngle(next.v1);
+  ServoValve2.setAngle(next.v2);
+  if (next.hz != cur.hz) motor.setFrequency(next.hz);
+  motor.set(next.duty);
+
+  Serial.printf("Setpoint #%lu -> v1 %.1f deg, v2 %.1f deg, motor %.3f @ %lu Hz\n",
+                (unsigned long)sp.seq, ServoValve1.angle(), ServoValve2.angle(),
+                motor.lastCommand(), (unsigned long)next.hz);
+  return true;
+}
+
 // ── Build dual-IMU CSV line ───────────────────────────────────────────────────
 String buildDualImuCsv() {
-  // Update both IMUs; collect their CSV into strings without trailing newline.
-  imu1.update();
-  imu2.update();
-
+  // Collect both IMUs' latest CSV into strings without trailing newline
+  // (the TX task has already drained the UARTs).
   StringStreamSink p1, p2;
   imu1.printCSV(p1);
   imu2.printCSV(p2);
@@ -298,17 +419,33 @@ String buildDualImuCsv() {
 // ── 100 Hz ESP-NOW TX task ───────────────────────────────────────────────────
 void EspNowTxTask(void* arg) {
   (void)arg;
-  const TickType_t period = pdMS_TO_TICKS(10); // 100 Hz
   TickType_t next = xTaskGetTickCount();
+  char buf[Telemetry::MAX_LINE + 1];
 
   for (;;) {
+    // 100 Hz by default; CONFIG rate_hz changes the period
+    TickType_t period = telemetry.configured() ? pdMS_TO_TICKS(telemetry.periodMs())
+                                               : pdMS_TO_TICKS(10);
     vTaskDelayUntil(&next, period);
 
-    String csv = buildDualImuCsv();
-    // Optional: echo to USB for debug
-    // Serial.print(csv);
+    // Drain both UARTs every tick (update() stops after one packet), so a
+    // rate_hz below the IMU output rate never lets the backlog grow
+    bool fresh1 = false, fresh2 = false;
+    while (imu1.update()) fresh1 = true;
+    while (imu2.update()) fresh2 = true;
+    estimator.update(imu1, imu2, fresh1, fresh2);
+
+    if (!telemetry.configured()) {
+      String csv = buildDualImuCsv();
+      // Optional: echo to USB for debug
+      // Serial.print(csv);
+
+      // Send over ESP-NOW (silently ignore if not initialized)
+      EspNow_send(csv);
+      continue;
+    }
 
-    // Send over ESP-NOW (silently ignore if not initialized)
-    EspNow_send(csv);
+    size_t n = telemetry.build(millis(), EspNow_txCount(), buf, sizeof(buf));
+    EspNow_send(reinterpret_cast<const uint8_t*>(buf), n);
   }
 }
@@ -0,0 +1,115 @@
+#include "Setpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+static float clampf(float v, float lo, float hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+// Case-insensitive prefix match
+static bool startsWith(const char* s, const char* prefix) {
+  for (; *prefix; ++s, ++prefix) {
+    if (tolower((unsigned char)*s) != *prefix) return false;
+  }
+  return true;
+}
+
+static bool onlySpaces(const char* s) {
+  while (*s && isspace((unsigned char)*s)) ++s;
+  return *s == '\0';
+}
+
+Setpoint Setpoint_initial(uint32_t session) {
+  Setpoint sp;
+  sp.session = session;
+  sp.seq     = 0;
+  sp.v1      = 0.0f;
+  sp.v2      = 0.0f;
+  sp.duty    = 0.0f;
+  sp.hz      = 1000;
+  return sp;
+}
+
+bool Setpoint_fold(const char* cmd, Setpoint& sp) {
+  while (*cmd && isspace((unsigned char)*cmd)) ++cmd;
+  Setpoint next = sp;
+
+  if (startsWith(cmd, "sp ")) {
+    // PC-side compound form, exactly four numbers: "sp <v1> <v2> <duty> <hz>".
+    // The onboard form carries session + seq and must not be typed here.
+    unsigned long hz = 0;
+    float v1 = 0, v2 = 0, duty = 0;
+    int end = -1;
+    if (sscanf(cmd + 3, " %f %f %f %lu%n", &v1, &v2, &duty, &hz, &end) != 4 ||
+        end < 0 || !onlySpaces(cmd + 3 + end)) {
+      return false;
+    }
+    next.v1 = v1; next.v2 = v2; next.duty = duty; next.hz = (uint32_t)hz;
+  } else if (startsWith(cmd, "s1")) {
+    next.v1 = strtof(cmd + 2, nullptr);
+  } else if (startsWith(cmd, "s2")) {
+    next.v2 = strtof(cmd + 2, nullptr);
+  } else if (startsWith(cmd, "mstop") && onlySpaces(cmd + 5)) {
+    next.duty = 0.0f;
+  } else if (startsWith(cmd, "mf ")) {
+    next.hz = (uint32_t)strtoul(cmd + 3, nullptr, 10);
+  } else if (startsWith(cmd, "m")) {
+    const char* arg = cmd + 1;
+    while (*arg == ' ') ++arg;
+    if (!*arg) return false;
+    next.duty = strtof(arg, nullptr);
+  } else {
+    return false;
+  }
+
+  next.v1   = clampf(next.v1, 0.0f, 90.0f);
+  next.v2   = clampf(next.v2, 0.0f, 90.0f);
+  next.duty = clampf(next.duty, -1.0f, 1.0f);
+  if (next.hz < 100)  next.hz = 100;
+  if (next.hz > 2000) next.hz = 2000;
+  sp = next;
+  return true;
+}
+
+size_t Setpoint_format(const Setpoint& sp, char* buf, size_t cap) {
+  if (!cap) return 0;
+  int n = snprintf(buf, cap, "sp %lu %lu %.2f %.2f %.3f %lu",
+                   (unsigned long)sp.session, (unsigned long)sp.seq,
+                   sp.v1, sp.v2, sp.duty, (unsigned long)sp.hz);
+  return (n < 0) ? 0 : ((size_t)n < cap ? (size_t)n : cap - 1);
+}
+
+bool SetpointAck_parse(const char* payload, uint32_t& session, uint32_t& seq) {
+  unsigned long s = 0, q = 0;
+  int end = -1;
+  if (sscanf(payload, "ack %lu %lu%n", &s, &q, &end) != 2 || end < 0 ||
+      !onlySpaces(payload + end)) {
+    return false;
+  }
+  session = (uint32_t)s;
+  seq     = (uint32_t)q;
+  return true;
+}
+
+const Setpoint& SetpointTx::change(const Setpoint& next) {
+  sp_.v1   = next.v1;
+  sp_.v2   = next.v2;
+  sp_.duty = next.duty;
+  sp_.hz   = next.hz;
+  sp_.seq++;
+  have_  = true;
+  acked_ = false;
+  ticks_ = 0;
+  return sp_;
+}
+
+bool SetpointTx::tick(bool rxRecent) {
+  if (!have_) return false;
+  if (!rxRecent) return true;
+  if (acked_) return false;
+  return (++ticks_ % RESEND_EVERY) == 0;
+}
+
+void SetpointTx::onAck(uint32_t session, uint32_t seq) {
+  if (session == sp_.session && seq == sp_.seq) acked_ = true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Whole actuator state, sent to the onboard as one packet:
+//   "sp <session> <seq> <v1> <v2> <duty> <hz>"
+// session is random per dongle boot, seq increments per change, so the
+// onboard can drop duplicates/stale resends and resync after a reboot.
+// Plain C strings only, so it also builds on the host (see test/).
+struct Setpoint {
+  uint32_t session;
+  uint32_t seq;
+  float    v1, v2;   // valve angles (deg, 0..90)
+  float    duty;     // motor [-1..1]
+  uint32_t hz;       // motor PWM (100..2000)
+};
+
+// Onboard boot state: valves closed, motor stopped @ 1000 Hz
+Setpoint Setpoint_initial(uint32_t session);
+
+// Fold one actuator command (s1/s2/m/mf/mstop, or "sp <v1> <v2> <duty> <hz>")
+// into sp, with the same syntax/limits as the onboard parser. seq is not
+// touched. Returns false (sp unchanged) for anything else or a malformed line.
+bool Setpoint_fold(const char* cmd, Setpoint& sp);
+
+// Wire format; returns length written (excluding NUL)
+size_t Setpoint_format(const Setpoint& sp, char* buf, size_t cap);
+
+// Parse the onboard's "ack <session> <seq>" (see SetpointAck_format onboard)
+bool SetpointAck_parse(const char* payload, uint32_t& session, uint32_t& seq);
+
+// Send side: the latest setpoint goes out once per change and is re-sent only
+// until the onboard acks that (session, seq). While the onboard is silent
+// (no telemetry, e.g. rebooting) it is re-sent every tick, acked or not.
+class SetpointTx {
+public:
+  static constexpr uint32_t RESEND_EVERY = 10;   // ticks while unacked (10 Hz @ 100 Hz)
+
+  explicit SetpointTx(uint32_t session) : sp_(Setpoint_initial(session)) {}
+
+  // Take the folded actuator values from next, bump seq; send current() now
+  const Setpoint& change(const Setpoint& next);
+
+  // One resend tick; true → send current() again
+  bool tick(bool rxRecent);
+
+  // Ack from the onboard; only the latest (session, seq) stops the resend
+  void onAck(uint32_t session, uint32_t seq);
+
+  const Setpoint& current() const { return sp_; }
+  bool have()  const { return have_; }
+  bool acked() const { return acked_; }
+
+private:
+  Setpoint sp_;
+  bool     have_  = false;   // nothing to resend before the first actuator cmd
+  bool     acked_ = false;
+  uint32_t ticks_ = 0;
+};
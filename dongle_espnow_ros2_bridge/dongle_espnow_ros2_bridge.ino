@@ -1,9 +1,19 @@
-// === DONGLE — ESP-NOW bridge with 100 Hz resend fallback =====================
+// === DONGLE — ESP-NOW bridge with acked setpoint resend ======================
 // - IDF 5.x compatible callbacks
 // - Read commands from Serial @115200 (e.g., "m0.2", "s1 45", "mf 200", "mstop")
-// - Send command immediately, and keep re-sending it at 100 Hz **only when**
-//   no ESP-NOW traffic has been received recently from the onboard peer.
-// - Print any received payloads (CSV telemetry) to Serial.
+// - Actuator commands (s1/s2/m/mf/mstop, or "sp <v1> <v2> <duty> <hz>") are
+//   folded into one setpoint (valve1, valve2, motor duty, PWM Hz) and sent as
+//   a single "sp <session> <seq> <v1> <v2> <duty> <hz>" packet, applied
+//   atomically onboard. session is random per boot, so the onboard resyncs
+//   its seq filter after a dongle reboot.
+// - The first actuator command after boot sends the *whole* setpoint, i.e.
+//   the other actuators go to their boot values (valves 0, motor 0 @ 1000 Hz).
+// - The onboard acks each setpoint ("ack <session> <seq>"). Until then the
+//   whole setpoint is re-sent at 10 Hz; once acked, nothing is re-sent. When
+//   no ESP-NOW traffic has been received recently from the onboard peer it is
+//   re-sent at 100 Hz, acked or not.
+// - Other commands (status, CONFIG, ...) are forwarded once, as typed.
+// - Print any received payloads (CSV telemetry) to Serial, except acks.
 //
 // Replace ONBOARD_MAC with your onboard ESP32 MAC (STA).
 
@@ -11,6 +21,8 @@
 #include <WiFi.h>
 #include <esp_now.h>
 #include <esp_mac.h>   // esp_read_mac()
+#include <esp_random.h>
+#include "Setpoint.h"
 
 // ── SET THIS to the onboard ESP32's MAC (peer) ───────────────────────────────
 uint8_t ONBOARD_MAC[6] = { 0xCC, 0xBA, 0x97, 0x14, 0x0A, 0x14 }; // <-- CHANGE
@@ -31,15 +43,32 @@ bool readLine(String& out) {
 static volatile uint32_t g_rxCount = 0;
 static volatile TickType_t g_lastRxTick = 0;
 
-static String g_lastCmd;              // last non-empty serial command
-static TickType_t g_lastCmdTick = 0;  // when last command was submitted
 static const TickType_t RX_STILL_OK_MS = 50; // consider "receiving" if RX within this window
 
+// Whole actuator state + resend/ack state (see Setpoint.h); shared by loop(),
+// ResendTask and onRecv under g_spMux
+static SetpointTx g_tx(0);                              // session seeded in setup()
+static portMUX_TYPE g_spMux = portMUX_INITIALIZER_UNLOCKED;
+
 // ── Callbacks (IDF 5.x signatures) ───────────────────────────────────────────
 void onRecv(const esp_now_recv_info* info, const uint8_t* data, int len) {
   g_rxCount++;
   g_lastRxTick = xTaskGetTickCount();
 
+  // Setpoint ack: stops the resend, not printed
+  if (data && len > 4 && len < 32 && memcmp(data, "ack ", 4) == 0) {
+    char buf[32];
+    memcpy(buf, data, len);
+    buf[len] = '\0';
+    uint32_t session, seq;
+    if (SetpointAck_parse(buf, session, seq)) {
+      portENTER_CRITICAL(&g_spMux);
+      g_tx.onAck(session, seq);
+      portEXIT_CRITICAL(&g_spMux);
+      return;
+    }
+  }
+
   // Print sender MAC and payload to Serial (telemetry CSV etc.)
   const uint8_t* mac = info ? info->src_addr : nullptr;
   if (mac) {
@@ -62,21 +91,30 @@ void onSent(const wifi_tx_info_t* tx_info, esp_now_send_status_t status) {
   // Serial.println(status == ESP_NOW_SEND_SUCCESS ? "[TX OK]" : "[TX FAIL]");
 }
 
-// ── 100 Hz task: resend last command only if no recent RX ────────────────────
+// ── 100 Hz task: resend the whole setpoint until acked, or if no recent RX ───
 void ResendTask(void* arg) {
   const TickType_t period = pdMS_TO_TICKS(10);  // 100 Hz
   TickType_t next = xTaskGetTickCount();
+  char buf[64];
 
   for (;;) {
     vTaskDelayUntil(&next, period);
 
-    // If no recent RX from peer, repeat the last command (if any)
+    // Repeat the current setpoint (if any) at 10 Hz until acked, every tick if
+    // no recent RX from peer. Same seq → the onboard only acks it again.
     TickType_t now = xTaskGetTickCount();
     bool recentlyReceiving = (now - g_lastRxTick) <= pdMS_TO_TICKS(RX_STILL_OK_MS);
 
-    if (!recentlyReceiving && g_lastCmd.length() > 0) {
-      esp_now_send(ONBOARD_MAC, (const uint8_t*)g_lastCmd.c_str(), g_lastCmd.length());
-      // optional: Serial.printf("[REPEAT @100Hz] %s\n", g_lastCmd.c_str());
+    Setpoint sp;
+    portENTER_CRITICAL(&g_spMux);
+    bool resend = g_tx.tick(recentlyReceiving);
+    sp = g_tx.current();
+    portEXIT_CRITICAL(&g_spMux);
+
+    if (resend) {
+      size_t n = Setpoint_format(sp, buf, sizeof(buf));
+      esp_now_send(ONBOARD_MAC, (const uint8_t*)buf, n);
+      // optional: Serial.printf("[REPEAT] %s\n", buf);
     }
   }
 }
@@ -112,22 +150,46 @@ void setup() {
     Serial.println("[ESP-NOW] ready.");
   }
 
+  // New setpoint session per boot
+  g_tx = SetpointTx(esp_random());
+  Serial.printf("[DONGLE] setpoint session %lu\n", (unsigned long)g_tx.current().session);
+
   // Start 100 Hz resend task
   xTaskCreatePinnedToCore(ResendTask, "resend_100hz", 4096, nullptr, 2, nullptr, APP_CPU_NUM);
 
-  Serial.println("Type commands like: m0.25  |  s1 45  |  s2 30  |  mf 200  |  mstop");
+  Serial.println("Type commands like: m0.25  |  s1 45  |  s2 30  |  mf 200  |  mstop  |  sp 45 30 0.25 1000");
 }
 
 void loop() {
-  // Read a full line from Serial; send immediately; remember it as last command
+  // Read a full line from Serial; actuator commands update the setpoint and
+  // send it as one packet, anything else is forwarded as-is
   if (readLine(line)) {
     String cmd = line; cmd.trim();
     if (cmd.length()) {
-      esp_now_send(ONBOARD_MAC, (const uint8_t*)cmd.c_str(), cmd.length());
-      g_lastCmd = cmd;
-      g_lastCmdTick = xTaskGetTickCount();
-      // Optional echo:
-      // Serial.printf("[TX NOW] %s\n", cmd.c_str());
+      Setpoint sp;
+      portENTER_CRITICAL(&g_spMux);
+      sp = g_tx.current();
+      portEXIT_CRITICAL(&g_spMux);
+
+      if (Setpoint_fold(cmd.c_str(), sp)) {
+        portENTER_CRITICAL(&g_spMux);
+        sp = g_tx.change(sp);
+        portEXIT_CRITICAL(&g_spMux);
+
+        char buf[64];
+        size_t n = Setpoint_format(sp, buf, sizeof(buf));
+        esp_now_send(ONBOARD_MAC, (const uint8_t*)buf, n);
+        // Optional echo:
+        // Serial.printf("[TX NOW] %s\n", buf);
+      } else if (cmd.startsWith("sp ") || cmd.startsWith("SP ")) {
+        Serial.println("[DONGLE] usage: sp <v1> <v2> <duty> <hz>  (dongle adds session + seq)");
+      } else if (cmd.length() > ESP_NOW_MAX_DATA_LEN) {
+        // e.g. a long CONFIG: would be dropped by esp_now_send without a reply
+        Serial.printf("[DONGLE] ERR command too long for ESP-NOW (%u > %u bytes)\n",
+                      (unsigned)cmd.length(), (unsigned)ESP_NOW_MAX_DATA_LEN);
+      } else if (esp_now_send(ONBOARD_MAC, (const uint8_t*)cmd.c_str(), cmd.length()) != ESP_OK) {
+        Serial.println("[DONGLE] ERR esp_now_send failed");
+      }
     }
     line = "";
   }
@@ -0,0 +1,24 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+
+// Minimal assertion helpers; each test binary returns the failure count.
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+  if (!(cond)) { std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); ++g_failures; } \
+} while (0)
+
+#define CHECK_NEAR(a, b, tol) do { \
+  double a_ = (a), b_ = (b); \
+  if (!(std::fabs(a_ - b_) <= (tol))) { \
+    std::printf("%s:%d: CHECK_NEAR(%s, %s) failed: %g vs %g\n", __FILE__, __LINE__, #a, #b, a_, b_); \
+    ++g_failures; \
+  } \
+} while (0)
+
+#define TEST_MAIN_END() do { \
+  if (g_failures) std::printf("%d check(s) failed\n", g_failures); \
+  else std::printf("all checks passed\n"); \
+  return g_failures ? 1 : 0; \
+} while (0)
@@ -0,0 +1,39 @@
+#pragma once
+// Just enough of the Arduino core to build Movella + Estimator on the host.
+// HardwareSerial is a byte FIFO the test fills with Xbus packets.
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+
+#define F(s) (s)
+#define SERIAL_8N1 0
+
+inline unsigned long millis() { return 0; }
+inline float degrees(float rad) { return rad * 57.29577951f; }
+
+class Stream {
+public:
+  virtual ~Stream() = default;
+  virtual int available() = 0;
+  virtual int read() = 0;
+  size_t print(float, int = 2) { return 0; }
+  size_t print(char) { return 0; }
+  size_t println(int) { return 0; }
+  size_t println(const char*) { return 0; }
+};
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long, int = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+  int available() override { return (int)rx_.size(); }
+  int read() override {
+    if (rx_.empty()) return -1;
+    int b = rx_.front(); rx_.pop_front(); return b;
+  }
+  void push(const uint8_t* data, size_t n) { rx_.insert(rx_.end(), data, data + n); }
+
+private:
+  std::deque<uint8_t> rx_;
+};
@@ -0,0 +1,252 @@
+// Estimator: quaternion helpers against hand/matrix reference results, and
+// the full update() fed through Movella with synthetic Xbus packets.
+#include "Estimator.h"
+#include "Movella.h"
+#include "check.h"
+
+namespace {
+
+const float PI_F = 3.14159265f;
+const float TOL  = 1e-5f;
+
+// Axis-angle → unit quaternion (w,x,y,z)
+void axisAngle(float ax, float ay, float az, float angle, float q[4]) {
+  float n = std::sqrt(ax*ax + ay*ay + az*az), s = std::sin(angle / 2) / n;
+  q[0] = std::cos(angle / 2); q[1] = ax * s; q[2] = ay * s; q[3] = az * s;
+}
+
+// Reference rotation matrix (sensor → global) from a unit quaternion
+void toMatrix(const float q[4], float R[3][3]) {
+  float w = q[0], x = q[1], y = q[2], z = q[3];
+  R[0][0] = 1 - 2*(y*y + z*z); R[0][1] = 2*(x*y - w*z);     R[0][2] = 2*(x*z + w*y);
+  R[1][0] = 2*(x*y + w*z);     R[1][1] = 1 - 2*(x*x + z*z); R[1][2] = 2*(y*z - w*x);
+  R[2][0] = 2*(x*z - w*y);     R[2][1] = 2*(y*z + w*x);     R[2][2] = 1 - 2*(x*x + y*y);
+}
+
+// Plain Hamilton product a·b
+void mul(const float a[4], const float b[4], float out[4]) {
+  out[0] = a[0]*b[0] - a[1]*b[1] - a[2]*b[2] - a[3]*b[3];
+  out[1] = a[0]*b[1] + a[1]*b[0] + a[2]*b[3] - a[3]*b[2];
+  out[2] = a[0]*b[2] - a[1]*b[3] + a[2]*b[0] + a[3]*b[1];
+  out[3] = a[0]*b[3] + a[1]*b[2] - a[2]*b[1] + a[3]*b[0];
+}
+
+void checkQuat(const float got[4], const float want[4]) {
+  for (int i = 0; i < 4; ++i) CHECK_NEAR(got[i], want[i], TOL);
+}
+
+// ---- Synthetic MTi output through the real Movella parser ----
+void putBlock(uint8_t*& p, uint8_t id0, uint8_t id1, const float* v, int n) {
+  *p++ = id0; *p++ = id1; *p++ = uint8_t(n * 4);
+  for (int i = 0; i < n; ++i) {
+    uint32_t u; std::memcpy(&u, &v[i], 4);
+    *p++ = uint8_t(u >> 24); *p++ = uint8_t(u >> 16); *p++ = uint8_t(u >> 8); *p++ = uint8_t(u);
+  }
+}
+
+struct Imu {
+  HardwareSerial port;
+  Movella        dev;
+  explicit Imu(int id) : dev(port, id) {}
+
+  bool feed(const float q[4], const float acc[3], const float gyro[3]) {
+    uint8_t pkt[64], *p = pkt + 4;
+    putBlock(p, 0x20, 0x10, q, 4);
+    putBlock(p, 0x40, 0x20, acc, 3);
+    putBlock(p, 0x80, 0x20, gyro, 3);
+    pkt[0] = 0xFA; pkt[1] = 0xFF; pkt[2] = 0x36; pkt[3] = uint8_t(p - pkt - 4);
+    *p++ = 0;   // checksum (not verified by Movella)
+    port.push(pkt, size_t(p - pkt));
+    return dev.update();
+  }
+};
+
+const float GRAV[3] = { 0, 0, 9.81f };
+const float ZERO[3] = { 0, 0, 0 };
+
+// ---- Helpers ----
+void testConjMul() {
+  float a[4], b[4], r[4], want[4], id[4] = {1, 0, 0, 0};
+  axisAngle(0, 0, 1, PI_F / 2, a);
+  axisAngle(0, 0, 1, PI_F, b);
+  Estimator::quatConjMul(a, b, r);
+  axisAngle(0, 0, 1, PI_F / 2, want);
+  checkQuat(r, want);
+
+  axisAngle(1, 2, 3, 0.7f, a);
+  Estimator::quatConjMul(a, a, r);
+  checkQuat(r, id);
+
+  // a · (a⁻¹·b) == b for non-trivial axes
+  axisAngle(-1, 0.5f, 2, 1.9f, b);
+  Estimator::quatConjMul(a, b, r);
+  mul(a, r, want);
+  checkQuat(want, b);
+}
+
+void testRotateInv() {
+  float q[4], v[3] = {1, 0, 0}, out[3];
+  axisAngle(0, 0, 1, PI_F / 2, q);
+  Estimator::quatRotateInv(q, v, out);
+  CHECK_NEAR(out[0], 0, TOL); CHECK_NEAR(out[1], -1, TOL); CHECK_NEAR(out[2], 0, TOL);
+
+  // Against Rᵀ·v from the reference matrix
+  float R[3][3], w[3] = {0.3f, -1.2f, 2.5f};
+  axisAngle(0.2f, -1, 0.4f, 2.3f, q);
+  toMatrix(q, R);
+  Estimator::quatRotateInv(q, w, out);
+  for (int i = 0; i < 3; ++i) {
+    CHECK_NEAR(out[i], R[0][i]*w[0] + R[1][i]*w[1] + R[2][i]*w[2], 1e-5);
+  }
+}
+
+void testAngleAndTilt() {
+  float q[4];
+  axisAngle(1, 0, 0, PI_F / 2, q);
+  CHECK_NEAR(Estimator::quatAngle(q), PI_F / 2, TOL);
+  CHECK_NEAR(Estimator::quatTilt(q), PI_F / 2, TOL);
+
+  axisAngle(0, 1, 0, PI_F / 6, q);
+  CHECK_NEAR(Estimator::quatAngle(q), PI_F / 6, TOL);
+  CHECK_NEAR(Estimator::quatTilt(q), PI_F / 6, 1e-4);
+
+  axisAngle(0, 0, 1, 1.0f, q);                // yaw only: no tilt
+  CHECK_NEAR(Estimator::quatTilt(q), 0, 1e-3);
+
+  axisAngle(1, 1, 0, 1e-3f, q);               // small angles stay accurate
+  CHECK_NEAR(Estimator::quatAngle(q), 1e-3, 1e-6);
+
+  axisAngle(0, 1, 0, PI_F, q);
+  CHECK_NEAR(Estimator::quatAngle(q), PI_F, 1e-4);
+  CHECK_NEAR(Estimator::quatTilt(q), PI_F, 1e-3);
+
+  for (int i = 0; i < 4; ++i) q[i] = -q[i];  // −q is the same rotation
+  CHECK_NEAR(Estimator::quatAngle(q), PI_F, 1e-4);
+}
+
+// 90° about x between the IMUs, as in the on-robot check
+void testRelative90x() {
+  Imu i1(1), i2(2);
+  Estimator est;
+  float q1[4] = {1, 0, 0, 0}, q2[4];
+  axisAngle(1, 0, 0, PI_F / 2, q2);
+  CHECK(i1.feed(q1, GRAV, ZERO));
+  CHECK(i2.feed(q2, GRAV, ZERO));
+  est.update(i1.dev, i2.dev, true, true);
+
+  float qrel[4], w[3];
+  est.getRelQuaternion(qrel);
+  checkQuat(qrel, q2);
+  CHECK_NEAR(est.jointAngle(), PI_F / 2, TOL);
+  CHECK_NEAR(est.tilt(1), 0, TOL);
+  CHECK_NEAR(est.tilt(2), PI_F / 2, TOL);
+  est.getRelGyro(w);
+  for (int i = 0; i < 3; ++i) CHECK_NEAR(w[i], 0, TOL);
+}
+
+// Rigidly attached pair: q2 = q1·qoff, ω2 = R(qoff)ᵀ ω1 → qrel = qoff, wrel = 0
+void testRigidPair() {
+  Imu i1(1), i2(2);
+  Estimator est;
+  float qoff[4], q1[4], q2[4], g1[3] = {0.4f, -0.9f, 1.3f}, g2[3];
+  axisAngle(0.3f, 1, -0.5f, 0.8f, qoff);
+  for (int k = 0; k < 20; ++k) {
+    axisAngle(1, -0.2f, 0.6f, 0.1f * k, q1);
+    mul(q1, qoff, q2);
+    Estimator::quatRotateInv(qoff, g1, g2);
+    CHECK(i1.feed(q1, GRAV, g1));
+    CHECK(i2.feed(q2, GRAV, g2));
+    est.update(i1.dev, i2.dev, true, true);
+
+    float qrel[4], w[3];
+    est.getRelQuaternion(qrel);
+    checkQuat(qrel, qoff);
+    CHECK_NEAR(est.jointAngle(), 0.8f, TOL);
+    est.getRelGyro(w);
+    for (int i = 0; i < 3; ++i) CHECK_NEAR(w[i], 0, 1e-5);
+  }
+}
+
+// Relative rotation whose product lands at w < 0 is flipped to w >= 0
+void testHemisphereFlip() {
+  Imu i1(1), i2(2);
+  Estimator est;
+  float q1[4] = {1, 0, 0, 0}, q2[4];
+  axisAngle(0, 0, 1, 0.5f, q2);
+  for (int i = 0; i < 4; ++i) q2[i] = -q2[i];
+  i1.feed(q1, GRAV, ZERO);
+  i2.feed(q2, GRAV, ZERO);
+  est.update(i1.dev, i2.dev, true, true);
+
+  float qrel[4], want[4];
+  est.getRelQuaternion(qrel);
+  axisAngle(0, 0, 1, 0.5f, want);
+  CHECK(qrel[0] >= 0);
+  checkQuat(qrel, want);
+  CHECK_NEAR(est.jointAngle(), 0.5f, TOL);
+}
+
+void testBias() {
+  Imu i1(1), i2(2);
+  Estimator est;
+  float q[4] = {1, 0, 0, 0}, b1[3] = {0.01f, -0.02f, 0.015f}, out[3];
+
+  // Still: after stillCount samples the EMA converges to the offset
+  for (int k = 0; k < 1000; ++k) {
+    i1.feed(q, GRAV, b1);
+    i2.feed(q, GRAV, ZERO);
+    est.update(i1.dev, i2.dev, true, true);
+  }
+  est.getBias(1, out);
+  for (int i = 0; i < 3; ++i) CHECK_NEAR(out[i], b1[i], 1e-5);
+  est.getGyro(1, out);
+  for (int i = 0; i < 3; ++i) CHECK_NEAR(out[i], 0, 1e-5);
+  est.getBias(2, out);
+  for (int i = 0; i < 3; ++i) CHECK_NEAR(out[i], 0, 1e-9);
+
+  // Moving or stale samples do not change the bias
+  float turning[3] = {0, 0, 1.0f}, bias[3];
+  est.getBias(1, bias);
+  for (int k = 0; k < 200; ++k) {
+    i1.feed(q, GRAV, turning);
+    est.update(i1.dev, i2.dev, true, false);
+  }
+  est.getBias(1, out);
+  for (int i = 0; i < 3; ++i) CHECK_NEAR(out[i], bias[i], 1e-9);
+  est.getGyro(1, out);
+  CHECK_NEAR(out[2], 1.0f - bias[2], 1e-6);
+
+  // Free fall / impact (|a| far from g) is not "still"
+  float fall[3] = {0, 0, 2.0f}, off[3] = {0.03f, 0, 0};
+  for (int k = 0; k < 200; ++k) {
+    i1.feed(q, fall, off);
+    est.update(i1.dev, i2.dev, true, false);
+  }
+  est.getBias(1, out);
+  CHECK_NEAR(out[0], bias[0], 1e-9);
+
+  est.resetBias();
+  est.getBias(1, out);
+  for (int i = 0; i < 3; ++i) CHECK(out[i] == 0.0f);
+
+  // After a reset, learning waits for stillCount samples again
+  for (int k = 0; k < est.stillCount; ++k) {
+    i1.feed(q, GRAV, b1);
+    est.update(i1.dev, i2.dev, true, false);
+  }
+  est.getBias(1, out);
+  CHECK(out[0] == 0.0f);
+}
+
+}  // namespace
+
+int main() {
+  testConjMul();
+  testRotateInv();
+  testAngleAndTilt();
+  testRelative90x();
+  testRigidPair();
+  testHemisphereFlip();
+  testBias();
+  TEST_MAIN_END();
+}
@@ -0,0 +1,394 @@
+// Compound setpoint: dongle folding/format (Setpoint.*) → onboard parse +
+// seq filter + apply (SetpointRx.*). Checks that every state the onboard applies is a
+// whole dongle state, and reports packets on air for typical gait sequences.
+#include "Setpoint.h"
+#include "SetpointRx.h"
+#include "check.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Actuators = SetpointState;
+
+bool operator==(const SetpointState& a, const SetpointState& b) {
+  return a.v1 == b.v1 && a.v2 == b.v2 && a.duty == b.duty && a.hz == b.hz;
+}
+
+// Round-trip through the wire format and the onboard clamps, like the
+// onboard applies it
+Actuators wire(const Setpoint& sp) {
+  char buf[64];
+  Setpoint_format(sp, buf, sizeof(buf));
+  SetpointMsg m{};
+  SetpointMsg_parse(buf + 3, m);
+  return SetpointMsg_apply(m, SetpointFilter::APPLY, Actuators{});
+}
+
+// Onboard side, as handleSetpoint: parse, filter, apply the whole state;
+// the PWM frequency is only reprogrammed when it changes
+struct Onboard {
+  SetpointFilter filter;
+  Actuators state { 0, 0, 0, 1000 };
+  int applied = 0, setFrequency = 0;
+  std::string ack;   // reply packet for the last receive, empty if none
+
+  SetpointFilter::Verdict receive(const char* pkt) {
+    SetpointMsg m{};
+    bool ok = std::strncmp(pkt, "sp ", 3) == 0 && SetpointMsg_parse(pkt + 3, m);
+    CHECK(ok);
+    SetpointFilter::Verdict v = filter.accept(m);
+    ack.clear();
+    if (v != SetpointFilter::STALE) {
+      char buf[32];
+      SetpointAck_format(m, buf, sizeof(buf));
+      ack = buf;
+    }
+    Actuators next = SetpointMsg_apply(m, v, state);
+    if (next.hz != state.hz) ++setFrequency;
+    if (v == SetpointFilter::APPLY || v == SetpointFilter::NEW_SESSION) ++applied;
+    state = next;
+    return v;
+  }
+};
+
+// Dongle side, as loop(): fold a PC line into the current state, bump seq
+struct Dongle {
+  SetpointTx tx;
+  std::map<uint32_t, Actuators> sent;   // seq → whole state in that packet
+
+  explicit Dongle(uint32_t session) : tx(session) {}
+
+  bool command(const char* line, std::string& pkt) {
+    Setpoint sp = tx.current();
+    if (!Setpoint_fold(line, sp)) return false;
+    pkt = format(tx.change(sp));
+    sent[tx.current().seq] = wire(tx.current());
+    return true;
+  }
+
+  std::string resend() const { return format(tx.current()); }
+
+  void receive(const std::string& pkt) {
+    uint32_t session, seq;
+    CHECK(SetpointAck_parse(pkt.c_str(), session, seq));
+    tx.onAck(session, seq);
+  }
+
+  static std::string format(const Setpoint& sp) {
+    char buf[64];
+    Setpoint_format(sp, buf, sizeof(buf));
+    return buf;
+  }
+};
+
+struct Phase { float v1, v2, duty; };
+
+// Inchworm climb: grip, pull, regrip, release, push, regrip
+const std::vector<Phase> GAIT_CLIMB = {
+  {90, 0, 0.0f}, {90, 0, 0.6f}, {90, 90, 0.0f},
+  {0, 90, 0.0f}, {0, 90, -0.6f}, {90, 90, 0.0f},
+};
+// Controlled descent: alternate grips with the winch paying out
+const std::vector<Phase> GAIT_DESCEND = {
+  {90, 90, 0.0f}, {90, 0, -0.3f}, {90, 90, 0.0f}, {0, 90, -0.3f},
+};
+
+// ---- Timeline: 10 ms ticks (ResendTask), one gait phase every 500 ms ----
+const int PHASE_TICKS = 50;
+
+// How the PC drives the actuators
+enum Mode {
+  LEGACY,        // s1 + s2 + m per phase, forwarded as-is (no setpoint, no resend)
+  SP,            // one "sp <v1> <v2> <duty> <hz>" per phase
+  FOLDED,        // s1 + s2 + m per phase, each folded into a setpoint
+};
+
+// ESP-NOW link; drops every lossEvery-th packet (0 = lossless). noAcks: an
+// onboard that never acks, i.e. the previous always-on 10 Hz resend.
+struct Air {
+  int  lossEvery = 0;
+  bool noAcks    = false;
+  int  packets = 0, acks = 0, n = 0;
+
+  bool send()    { ++packets; return !(lossEvery && ++n % lossEvery == 0); }
+  bool sendAck() { if (noAcks) return false; ++acks; return send(); }
+};
+
+struct Run {
+  int packets = 0;      // everything on air: commands, resends, acks
+  int commands = 0, resends = 0, acks = 0;
+  int halfApplied = 0;  // onboard states that are neither the old nor the new phase
+  int missed = 0;       // phases that ended without the onboard at the target
+};
+
+Run simulate(const std::vector<Phase>& gait, int cycles, Mode mode, Air air) {
+  Run r;
+  Dongle dongle(0xD0D0);
+  Onboard onboard;
+  Setpoint legacy = Setpoint_initial(0);   // onboard state driven by plain s1/s2/m
+  Actuators prev = onboard.state;
+
+  auto state = [&]() {
+    return mode == LEGACY ? Actuators{ legacy.v1, legacy.v2, legacy.duty, legacy.hz }
+                          : onboard.state;
+  };
+  auto deliver = [&](const std::string& pkt, const Actuators& target) {
+    if (!air.send()) return;
+    if (mode == LEGACY) {
+      Setpoint_fold(pkt.c_str(), legacy);   // onboard parser, same syntax
+    } else {
+      onboard.receive(pkt.c_str());
+      if (!onboard.ack.empty() && air.sendAck()) dongle.receive(onboard.ack);
+    }
+    Actuators s = state();
+    if (!(s == prev) && !(s == target)) ++r.halfApplied;
+  };
+
+  char lines[3][48];
+  for (int k = 0; k < cycles; ++k) {
+    for (const Phase& p : gait) {
+      Actuators target = SetpointMsg_apply(SetpointMsg{ 0, 0, p.v1, p.v2, p.duty, 1000 },
+                                           SetpointFilter::APPLY, Actuators{});
+      int n = 0;
+      if (mode == SP) {
+        std::snprintf(lines[n++], sizeof(lines[0]), "sp %g %g %g 1000", p.v1, p.v2, p.duty);
+      } else {
+        std::snprintf(lines[n++], sizeof(lines[0]), "s1 %g", p.v1);
+        std::snprintf(lines[n++], sizeof(lines[0]), "s2 %g", p.v2);
+        std::snprintf(lines[n++], sizeof(lines[0]), "m%g", p.duty);
+      }
+
+      for (int t = 0; t < PHASE_TICKS; ++t) {
+        if (t == 0) {
+          for (int i = 0; i < n; ++i) {
+            std::string pkt = lines[i];
+            if (mode != LEGACY) CHECK(dongle.command(lines[i], pkt));
+            ++r.commands;
+            deliver(pkt, target);
+          }
+        }
+        // Telemetry keeps flowing, so only the unacked resend applies;
+        // the legacy dongle never resends while receiving
+        if (mode != LEGACY && dongle.tx.tick(true)) {
+          ++r.resends;
+          deliver(dongle.resend(), target);
+        }
+      }
+      if (!(state() == target)) ++r.missed;
+      prev = state();
+    }
+  }
+  r.packets = air.packets;
+  r.acks    = air.acks;
+  return r;
+}
+
+void testStrictPcForm() {
+  Setpoint sp = Setpoint_initial(1);
+  CHECK(Setpoint_fold("sp 45 30 0.25 1000", sp));
+  CHECK(sp.v1 == 45.0f && sp.v2 == 30.0f && sp.duty == 0.25f && sp.hz == 1000);
+
+  // The onboard form (with seq) typed at the dongle must not be misread
+  Setpoint before = sp;
+  CHECK(!Setpoint_fold("sp 7 45 30 0.5 1000", sp));
+  CHECK(!Setpoint_fold("sp 45 30 0.25", sp));
+  CHECK(!Setpoint_fold("sp 45 30 0.25 1000 x", sp));
+  CHECK(!Setpoint_fold("sp 45 30 abc 1000", sp));
+  CHECK(std::memcmp(&before, &sp, sizeof(sp)) == 0);
+
+  CHECK(Setpoint_fold("sp 45 30 0.25 1000  ", sp));   // trailing spaces are fine
+  CHECK(Setpoint_fold("s1 120", sp) && sp.v1 == 90.0f);   // clamped like ServoValve
+  CHECK(Setpoint_fold("m-2", sp) && sp.duty == -1.0f);
+  CHECK(Setpoint_fold("mf 50", sp) && sp.hz == 100);
+  CHECK(Setpoint_fold("mstop", sp) && sp.duty == 0.0f);
+  CHECK(!Setpoint_fold("status", sp));
+  CHECK(!Setpoint_fold("CONFIG {}", sp));
+}
+
+void testStrictOnboardForm() {
+  SetpointMsg m{};
+  CHECK(SetpointMsg_parse("12 3 45.00 30.00 0.250 1000", m));
+  CHECK(m.session == 12 && m.seq == 3 && m.v1 == 45.0f && m.hz == 1000);
+  CHECK(!SetpointMsg_parse("3 45 30 0.25 1000", m));         // old 5-field form
+  CHECK(!SetpointMsg_parse("12 3 45 30 0.25 1000 9", m));
+}
+
+// Apply: whole clamped state or nothing
+void testApply() {
+  const Actuators cur { 10, 20, 0.5f, 1000 };
+  SetpointMsg m{ 1, 2, 120, -5, -3, 50 };
+  Actuators s = SetpointMsg_apply(m, SetpointFilter::APPLY, cur);
+  CHECK(s.v1 == 90.0f && s.v2 == 0.0f && s.duty == -1.0f && s.hz == 100);
+  m = { 1, 2, 45, 30, 0.25f, 9000 };
+  s = SetpointMsg_apply(m, SetpointFilter::NEW_SESSION, cur);
+  CHECK(s.v1 == 45.0f && s.v2 == 30.0f && s.duty == 0.25f && s.hz == 2000);
+  CHECK(SetpointMsg_apply(m, SetpointFilter::DUPLICATE, cur) == cur);
+  CHECK(SetpointMsg_apply(m, SetpointFilter::STALE, cur) == cur);
+
+  // setFrequency only on an hz change, not on every duty/valve update
+  Onboard onboard;
+  std::string pkt;
+  Dongle dongle(5);
+  dongle.command("m0.5", pkt);   onboard.receive(pkt.c_str());
+  dongle.command("s1 40", pkt);  onboard.receive(pkt.c_str());
+  CHECK(onboard.setFrequency == 0);
+  dongle.command("mf 1500", pkt); onboard.receive(pkt.c_str());
+  dongle.command("m0.2", pkt);   onboard.receive(pkt.c_str());
+  CHECK(onboard.setFrequency == 1);
+  CHECK(onboard.state == (Actuators{ 40, 0, 0.2f, 1500 }));
+}
+
+// Every state the onboard ever holds is a whole dongle state, also with loss
+// and reordering; the periodic resend recovers a lost last packet.
+void testAtomicity() {
+  Dongle dongle(0xC0FFEE);
+  Onboard onboard;
+  std::vector<std::string> pkts;
+  std::string pkt;
+
+  char line[64];
+  for (int k = 0; k < 5; ++k) {
+    for (const Phase& p : GAIT_CLIMB) {
+      std::snprintf(line, sizeof(line), "sp %g %g %g 1000", p.v1, p.v2, p.duty);
+      CHECK(dongle.command(line, pkt));
+      pkts.push_back(pkt);
+    }
+  }
+
+  // Drop every 3rd packet, deliver every 4th one late (after its successor)
+  for (size_t i = 0; i < pkts.size(); ++i) {
+    if (i % 3 == 2) continue;
+    if (i % 4 == 1 && i + 1 < pkts.size()) {
+      onboard.receive(pkts[i + 1].c_str());
+      CHECK(onboard.receive(pkts[i].c_str()) == SetpointFilter::STALE);
+      ++i;
+    } else {
+      onboard.receive(pkts[i].c_str());
+    }
+    CHECK(onboard.state == dongle.sent[onboard.filter.seq()]);
+  }
+
+  // Resend of the full state: brings the onboard to the final state once,
+  // further resends are duplicates
+  onboard.receive(dongle.resend().c_str());
+  CHECK(onboard.state == wire(dongle.tx.current()));
+  CHECK(onboard.receive(dongle.resend().c_str()) == SetpointFilter::DUPLICATE);
+}
+
+// Dongle reboot: new session restarts at seq 1 and must still apply
+void testSessionReset() {
+  Onboard onboard;
+  std::string pkt;
+  Dongle first(111);
+  for (int i = 0; i < 5; ++i) first.command("m0.5", pkt);
+  CHECK(onboard.receive(pkt.c_str()) == SetpointFilter::NEW_SESSION);
+  CHECK(onboard.filter.seq() == 5);
+
+  Dongle second(222);
+  second.command("mstop", pkt);
+  CHECK(onboard.receive(pkt.c_str()) == SetpointFilter::NEW_SESSION);
+  CHECK(onboard.state.duty == 0.0f);
+  second.command("m0.1", pkt);
+  CHECK(onboard.receive(pkt.c_str()) == SetpointFilter::APPLY);
+
+  // seq wrap within a session is still "newer"
+  SetpointFilter f;
+  SetpointMsg m{ 7, 0xFFFFFFFFu, 0, 0, 0, 1000 };
+  f.accept(m);
+  m.seq = 0;
+  CHECK(f.accept(m) == SetpointFilter::APPLY);
+}
+
+// Resend stops on the ack of the latest seq only; a silent onboard gets every tick
+void testResend() {
+  SetpointTx tx(42);
+  CHECK(!tx.tick(true) && !tx.tick(false));   // nothing before the first command
+
+  Setpoint sp = tx.current();
+  CHECK(Setpoint_fold("m0.5", sp));
+  tx.change(sp);
+  CHECK(tx.current().seq == 1 && !tx.acked());
+  int resends = 0;
+  for (uint32_t k = 0; k < 10 * SetpointTx::RESEND_EVERY; ++k) resends += tx.tick(true);
+  CHECK(resends == 10);
+
+  char ack[32];
+  SetpointMsg m{ 42, 1, 0, 0, 0.5f, 1000 };
+  SetpointAck_format(m, ack, sizeof(ack));
+  CHECK(std::strcmp(ack, "ack 42 1") == 0);
+  uint32_t session = 0, seq = 0;
+  CHECK(SetpointAck_parse(ack, session, seq) && session == 42 && seq == 1);
+  CHECK(!SetpointAck_parse("ack 42", session, seq));
+  CHECK(!SetpointAck_parse("ack 42 1 x", session, seq));
+
+  tx.change(sp);                 // seq 2: an ack for seq 1 or another session is not enough
+  tx.onAck(42, 1);
+  tx.onAck(43, 2);
+  CHECK(!tx.acked());
+  tx.onAck(42, 2);
+  CHECK(tx.acked());
+  resends = 0;
+  for (uint32_t k = 0; k < 10 * SetpointTx::RESEND_EVERY; ++k) resends += tx.tick(true);
+  CHECK(resends == 0);
+  CHECK(tx.tick(false));         // onboard silent (e.g. rebooting): every tick
+}
+
+// Packets on air for typical gait sequences, through the real dongle fold/
+// resend/ack path and the real onboard parse/filter/apply path
+void testPacketCounts() {
+  const int cycles = 10;
+  struct { const char* name; const std::vector<Phase>* gait; } gaits[] = {
+    { "climb",   &GAIT_CLIMB },
+    { "descend", &GAIT_DESCEND },
+  };
+  struct { const char* name; Mode mode; Air air; } runs[] = {
+    { "legacy s1+s2+m",         LEGACY, Air{} },
+    { "sp + ack",               SP,     Air{} },
+    { "s1+s2+m folded + ack",   FOLDED, Air{} },
+    { "sp, no ack (10 Hz)",     SP,     Air{ 0, true } },
+    { "legacy, 10% loss",       LEGACY, Air{ 10, false } },
+    { "sp + ack, 10% loss",     SP,     Air{ 10, false } },
+  };
+  std::printf("%d cycles, %d ms/phase   packets (cmd + resend + ack)   half-applied   missed\n",
+              cycles, PHASE_TICKS * 10);
+  for (const auto& g : gaits) {
+    const int phases = cycles * (int)g.gait->size();
+    Run res[6];
+    for (int i = 0; i < 6; ++i) {
+      res[i] = simulate(*g.gait, cycles, runs[i].mode, runs[i].air);
+      std::printf("%-8s %-22s %4d (%3d + %3d + %3d)   %3d   %3d\n",
+                  g.name, runs[i].name, res[i].packets, res[i].commands, res[i].resends,
+                  res[i].acks, res[i].halfApplied, res[i].missed);
+    }
+    // Legacy: 3 lines per phase, intermediate states on the actuators
+    CHECK(res[0].packets == 3 * phases && res[0].halfApplied > 0 && res[0].missed == 0);
+    // sp + ack: one packet each way per phase, no resends, never half-applied
+    CHECK(res[1].packets == 2 * phases && res[1].resends == 0);
+    CHECK(res[1].halfApplied == 0 && res[1].missed == 0);
+    // Folding legacy lines keeps them whole-state but not phase-atomic
+    CHECK(res[2].commands == 3 * phases && res[2].resends == 0 && res[2].missed == 0);
+    // Without acks the resend never stops: what an always-on 10 Hz costs
+    CHECK(res[3].resends == phases * PHASE_TICKS / (int)SetpointTx::RESEND_EVERY);
+    CHECK(res[3].acks == 0 && res[3].packets > res[0].packets);
+    // Loss: legacy lines are gone for good, sp + ack recovers every phase
+    CHECK(res[4].missed > 0);
+    CHECK(res[5].missed == 0 && res[5].halfApplied == 0 && res[5].resends > 0);
+  }
+}
+
+}  // namespace
+
+int main() {
+  testStrictPcForm();
+  testStrictOnboardForm();
+  testApply();
+  testAtomicity();
+  testSessionReset();
+  testResend();
+  testPacketCounts();
+  TEST_MAIN_END();
+}
@@ -0,0 +1,193 @@
+// Telemetry plan compiler/formatter (TelemetryPlan.*): plans that could
+// overflow one ESP-NOW packet are rejected, and formatted lines never exceed
+// the worst-case width the plan was accepted with.
+#include "TelemetryPlan.h"
+#include "check.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Plan = TelemetryPlan;
+
+char err[96];
+
+// "source.path" shorthand at the plan rate, like the CONFIG string form
+bool add(Plan& p, const char* src, const char* path, uint32_t rateHz) {
+  err[0] = '\0';
+  return p.add(nullptr, src, path, rateHz, Plan::DEFAULT_PREC, err, sizeof(err));
+}
+
+std::vector<std::string> cells(const char* line) {
+  std::vector<std::string> out(1);
+  for (const char* c = line; *c && *c != '\n'; ++c) {
+    if (*c == ',') out.emplace_back();
+    else out.back() += *c;
+  }
+  return out;
+}
+
+// Every cell within its slot width, the whole line within width()
+void checkLine(const Plan& p, const char* line, size_t len, bool timestamp) {
+  CHECK(len <= p.width());
+  CHECK(len == std::strlen(line));
+  CHECK(line[len - 1] == '\n');
+  std::vector<std::string> c = cells(line);
+  size_t off = timestamp ? 1 : 0;
+  CHECK(c.size() == p.size() + off);
+  for (uint8_t i = 0; i < p.size() && i + off < c.size(); ++i) {
+    CHECK(c[i + off].size() <= p.slotWidth(i));
+  }
+}
+
+// Default "imu1.all" + "imu2.all" line: 22 channels in one packet
+void testDualImuFits() {
+  Plan p;
+  p.begin(100, true);
+  CHECK(add(p, "imu1", "all", 100));
+  CHECK(add(p, "imu2", "all", 100));
+  CHECK(p.finish(err, sizeof(err)));
+  CHECK(p.size() == 22);
+  CHECK(p.width() == 237);   // worst case; must stay <= MAX_LINE
+  CHECK(p.srcMask() == (Plan::SRC_IMU1 | Plan::SRC_IMU2));
+  CHECK(p.periodMs() == 10);
+
+  const char* h = p.header();
+  CHECK(std::strncmp(h, "ms,imu1.q0,imu1.q1,", 19) == 0);
+  CHECK(std::strstr(h, ",imu1.id,imu2.q0,") != nullptr);
+  CHECK(h[std::strlen(h) - 1] == '\n');
+  CHECK(cells(h).size() == 23);
+}
+
+void testRejected() {
+  // Short header names, so the data line is what overflows
+  Plan p;
+  p.begin(100, true);
+  CHECK(p.add("a", "imu1", "all", 100, 6, err, sizeof(err)));
+  CHECK(p.add("b", "imu2", "all", 100, 6, err, sizeof(err)));
+  CHECK(p.add("e", "est", "all", 100, 6, err, sizeof(err)));
+  CHECK(!p.finish(err, sizeof(err)));
+  CHECK(std::strstr(err, "line too long") != nullptr);
+
+  p.begin(100, true);
+  CHECK(!add(p, "imu1", "nope", 100));
+  CHECK(std::strcmp(err, "ERR CONFIG: unknown field imu1.nope") == 0);
+  CHECK(!add(p, "motor", "", 100));
+  CHECK(!add(p, "led", "on", 100));
+
+  p.begin(100, false);
+  for (int k = 0; k < 4; ++k) CHECK(p.add("q", "imu1", "all", 100, 0, err, sizeof(err)));
+  CHECK(!p.add("q", "imu1", "all", 100, 0, err, sizeof(err)));   // 55 > MAX_SLOTS
+  CHECK(std::strstr(err, "too many fields") != nullptr);
+
+  // Long names overflow the header before the data line
+  p.begin(100, false);
+  bool ok = true;
+  for (int k = 0; k < 20 && ok; ++k) {
+    ok = p.add("a_rather_long_name", "motor", "cmd", 100, 0, err, sizeof(err));
+  }
+  CHECK(!ok);
+  CHECK(std::strstr(err, "header too long") != nullptr);
+}
+
+// Saturated, NaN, inf, negative and huge values stay inside their cells
+void testWorstCaseValues() {
+  Plan p;
+  p.begin(200, true);
+  CHECK(add(p, "imu1", "all", 200));
+  CHECK(add(p, "imu2", "hz", 200));
+  CHECK(add(p, "motor", "cmd", 200));
+  CHECK(add(p, "motor", "hz", 200));
+  CHECK(add(p, "valve1", "", 200));
+  CHECK(add(p, "counter", "tx", 200));
+  CHECK(add(p, "est", "wrel", 200));
+  CHECK(p.add("q0", "imu2", "q0", 200, 0, err, sizeof(err)));   // "-nan" wider than "-9"
+  CHECK(p.finish(err, sizeof(err)));
+
+  const float NAN_F = std::numeric_limits<float>::quiet_NaN();
+  const float INF_F = std::numeric_limits<float>::infinity();
+  const float fills[] = { 0.f, -0.f, 1e9f, -1e9f, -9.999999f, NAN_F, -NAN_F, INF_F, -INF_F };
+  const uint32_t ufills[] = { 0, 12345, 0xFFFFFFFFu };
+
+  float f[Plan::CH_COUNT];
+  uint32_t u[Plan::CH_COUNT];
+  char line[Plan::MAX_LINE + 1];
+  for (float fv : fills) {
+    for (uint32_t uv : ufills) {
+      for (float& x : f) x = fv;
+      for (uint32_t& x : u) x = uv;
+      size_t len = p.format(0, 0xFFFFFFFFu, f, u, line, sizeof(line));
+      checkLine(p, line, len, true);
+    }
+  }
+
+  // Saturation keeps the sign and the limit
+  for (float& x : f) x = -1e9f;
+  for (uint32_t& x : u) x = 0xFFFFFFFFu;
+  p.format(0, 0, f, u, line, sizeof(line));
+  std::vector<std::string> c = cells(line);
+  CHECK(c[1] == "-9.000000");      // imu1.q0
+  CHECK(c[5] == "-999.000000");    // imu1.ax
+  CHECK(c[11] == "999");           // imu1.id
+  CHECK(c[14] == "9999");          // motor.hz
+  CHECK(c[16] == "4294967295");    // counter.tx
+}
+
+// Decimated fields give empty cells, so every line has the same columns
+void testDecimation() {
+  Plan p;
+  p.begin(100, false);
+  CHECK(add(p, "imu1", "quat", 100));
+  CHECK(p.add("joint", "est", "joint", 25, 3, err, sizeof(err)));
+  CHECK(p.add("duty", "motor", "cmd", 10, 2, err, sizeof(err)));
+  CHECK(p.finish(err, sizeof(err)));
+  CHECK(std::strcmp(p.header(), "imu1.q0,imu1.q1,imu1.q2,imu1.q3,joint,duty\n") == 0);
+
+  float f[Plan::CH_COUNT] = {0};
+  uint32_t u[Plan::CH_COUNT] = {0};
+  f[Plan::EST_QREL + 4] = 1.5f;
+  f[Plan::MOTOR_CMD] = -0.25f;
+  char line[Plan::MAX_LINE + 1];
+  int joints = 0, duties = 0;
+  for (uint32_t tick = 0; tick < 100; ++tick) {
+    size_t len = p.format(tick, 0, f, u, line, sizeof(line));
+    checkLine(p, line, len, false);
+    std::vector<std::string> c = cells(line);
+    CHECK(c[0] == "0.000000");
+    CHECK(c[4] == (tick % 4 == 0 ? "1.500" : ""));
+    CHECK(c[5] == (tick % 10 == 0 ? "-0.25" : ""));
+    joints += !c[4].empty();
+    duties += !c[5].empty();
+  }
+  CHECK(joints == 25);
+  CHECK(duties == 10);
+}
+
+// A short output buffer truncates but stays terminated
+void testShortBuffer() {
+  Plan p;
+  p.begin(100, true);
+  CHECK(add(p, "imu1", "all", 100));
+  CHECK(p.finish(err, sizeof(err)));
+  float f[Plan::CH_COUNT] = {0};
+  uint32_t u[Plan::CH_COUNT] = {0};
+  char line[16];
+  size_t len = p.format(0, 123, f, u, line, sizeof(line));
+  CHECK(len == sizeof(line) - 1);
+  CHECK(line[len - 1] == '\n' && line[len] == '\0');
+}
+
+}  // namespace
+
+int main() {
+  testDualImuFits();
+  testRejected();
+  testWorstCaseValues();
+  testDecimation();
+  testShortBuffer();
+  TEST_MAIN_END();
+}